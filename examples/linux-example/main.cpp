@@ -27,8 +27,9 @@ void onLed(EmbeddedCli *cli, char *args, void *context);
 void onAdc(EmbeddedCli *cli, char *args, void *context);
 
 int main() {
-    // Single character buffer for reading keystrokes
-    unsigned char c;
+    // Buffer for reading keystrokes (pasted text is read in large chunks).
+    // It is smaller than rx buffer of cli, so it always fits there
+    char chunk[32];
 
     // Structures to save the terminal settings for original settings & raw mode
     struct termios original_stdin;
@@ -40,14 +41,17 @@ int main() {
     cfmakeraw(&raw_stdin);
     tcsetattr(STDIN_FILENO, TCSANOW, &raw_stdin);
 
-    EmbeddedCli *cli = embeddedCliNewDefault();
+    EmbeddedCliConfig *config = embeddedCliDefaultConfig();
+    // collect output of each processing call so it is written with single syscall
+    config->txBufferSize = 128;
+    EmbeddedCli *cli = embeddedCliNew(config);
 
     cli->onCommand = [](EmbeddedCli *embeddedCli, CliCommand *command) {
         embeddedCliTokenizeArgs(command->args);
         onCommand(command->name == nullptr ? "" : command->name, command->args);
     };
-    cli->writeChar = [](EmbeddedCli *embeddedCli, char c) {
-        write(STDOUT_FILENO, &c, 1);
+    cli->writeChars = [](EmbeddedCli *embeddedCli, const char *buf, size_t len) {
+        write(STDOUT_FILENO, buf, len);
     };
 
     embeddedCliAddBinding(cli, {
@@ -86,9 +90,10 @@ int main() {
     embeddedCliProcess(cli);
 
     while (!exitFlag) {
-        // grab the next character and feed it to the CLI processor
-        if(read(STDIN_FILENO,&c,1)>0) {
-            embeddedCliReceiveChar(cli, c);
+        // grab all available characters and feed them to the CLI processor
+        ssize_t count = read(STDIN_FILENO, chunk, sizeof(chunk));
+        if (count > 0) {
+            embeddedCliReceiveBuffer(cli, chunk, (uint16_t) count);
             embeddedCliProcess(cli);
         }
     }
@@ -12,25 +12,19 @@
 
 // Definitions for CLI sizes
 #define CLI_BUFFER_SIZE 2048
-#define CLI_RX_BUFFER_SIZE 16
+#define CLI_TX_BUFFER_SIZE 128
 #define CLI_CMD_BUFFER_SIZE 32
 #define CLI_HISTORY_SIZE 32
 #define CLI_MAX_BINDING_COUNT 32
 
-/**
- * Definition of the cli_printf() buffer size.
- * Can make smaller to decrease RAM usage,
- * make larger to be able to print longer strings.
- */
-#define CLI_PRINT_BUFFER_SIZE 512
-
 // Definitions for CLI UART peripheral
 #define UART_CLI_PERIPH &huart1
 
 /**
- * Char for char is needed for instant char echo, so size 1
+ * Size of circular DMA buffer. It must hold all chars that are received
+ * between two calls to processCli()
  */
-#define UART_RX_BUFF_SIZE 1
+#define UART_RX_BUFF_SIZE 64
 
 /**
  * Function to setup the configuration settings for the CLI,
@@ -38,6 +32,13 @@
  */
 void setupCli();
 
+/**
+ * Function to process received chars, must be called periodically
+ * @return flags of remaining work (EmbeddedCliStatus), when no flags are set
+ * cli is idle until next char is received
+ */
+uint8_t processCli();
+
 /**
  * Function to encapsulate the 'embeddedCliPrint()' call with
  * print formatting arguments (act like printf(), but keeps cursor at correct location).
@@ -7,7 +7,6 @@
 
 
 // STD LIBS
-#include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 
@@ -24,8 +23,9 @@
 
 #include "embedded_cli.h"
 
-// UART buffers
-static uint8_t UART_CLI_rxBuffer[UART_RX_BUFF_SIZE] = {0};
+// UART buffers. Rx buffer is filled by DMA in circular mode and CLI reads
+// chars directly from it
+static char UART_CLI_rxBuffer[UART_RX_BUFF_SIZE] = {0};
 // CLI buffer
 static EmbeddedCli *cli;
 static CLI_UINT cliBuffer[BYTES_TO_CLI_UINTS(CLI_BUFFER_SIZE)];
@@ -33,30 +33,54 @@ static CLI_UINT cliBuffer[BYTES_TO_CLI_UINTS(CLI_BUFFER_SIZE)];
 // Bool to disable the interrupts, if CLI is not yet ready.
 static bool cliIsReady = false;
 
-// Write function used in 'setupCli()' to route the chars over UART.
-static void writeCharToCli(EmbeddedCli *embeddedCli, char c) {
-    uint8_t c_to_send = c;
-    HAL_UART_Transmit(UART_CLI_PERIPH, &c_to_send, 1, 100);
+// Set while UART is sending chunk of CLI tx buffer
+static volatile bool cliTxBusy = false;
+// Size of chunk that is currently sent
+static uint16_t cliTxSending = 0;
+
+// Start sending next contiguous chunk of CLI tx buffer (if UART is idle).
+// Must be called with UART interrupt disabled or from UART interrupt.
+static void startCliTransmit(EmbeddedCli *embeddedCli) {
+    const char *data;
+    uint16_t len;
+    if (cliTxBusy || !embeddedCliTxPeek(embeddedCli, &data, &len))
+        return;
+    cliTxBusy = true;
+    cliTxSending = len;
+    HAL_UART_Transmit_IT(UART_CLI_PERIPH, (const uint8_t *) data, len);
+}
+
+// Called by CLI when new output is put to tx buffer, used in 'setupCli()'.
+static void onCliTxAvailable(EmbeddedCli *embeddedCli) {
+    __disable_irq();
+    startCliTransmit(embeddedCli);
+    __enable_irq();
 }
 
 // Function to setup the configuration settings for the CLI, based on the definitions from this header file
 void setupCli() {
-    // UART interrupt
-    HAL_UART_Receive_IT(UART_CLI_PERIPH, UART_CLI_rxBuffer, UART_RX_BUFF_SIZE);
+    // UART rx DMA (circular), no interrupt per received char
+    HAL_UART_Receive_DMA(UART_CLI_PERIPH, (uint8_t *) UART_CLI_rxBuffer, UART_RX_BUFF_SIZE);
 
     // Initialize the CLI configuration settings
     EmbeddedCliConfig *config = embeddedCliDefaultConfig();
     config->cliBuffer = cliBuffer;
     config->cliBufferSize = CLI_BUFFER_SIZE;
-    config->rxBufferSize = CLI_RX_BUFFER_SIZE;
+    // DMA buffer is used instead of rx buffer
+    config->rxBufferSize = 0;
+    config->txBufferSize = CLI_TX_BUFFER_SIZE;
+    // Wait for UART interrupt to free space when output doesn't fit
+    config->txPolicy = CLI_TX_POLICY_BLOCK;
     config->cmdBufferSize = CLI_CMD_BUFFER_SIZE;
     config->historyBufferSize = CLI_HISTORY_SIZE;
     config->maxBindingCount = CLI_MAX_BINDING_COUNT;
 
     // Create new CLI instance
     cli = embeddedCliNew(config);
-    // Assign character write function
-    cli->writeChar = writeCharToCli;
+    // Output is sent from tx buffer with UART interrupts, so no write function
+    // is assigned. CLI will notify when there is something to send.
+    cli->onTxAvailable = onCliTxAvailable;
+    embeddedCliAttachRxBuffer(cli, UART_CLI_rxBuffer, UART_RX_BUFF_SIZE);
 
     // CLI init failed. Is there not enough memory allocated to the CLI?
     // Please increase the 'CLI_BUFFER_SIZE' in header file.
@@ -81,35 +105,31 @@ void setupCli() {
     cliIsReady = true;
 }
 
-// STM32 UART callback function, to pass received characters to the embedded-cli
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
-    if (huart == UART_CLI_PERIPH && cliIsReady) {
-        HAL_UART_Receive_IT(UART_CLI_PERIPH, UART_CLI_rxBuffer, UART_RX_BUFF_SIZE);
-        char c = UART_CLI_rxBuffer[0];
-        embeddedCliReceiveChar(cli, c);
+// Process chars that DMA has written to rx buffer since last call
+uint8_t processCli() {
+    if (!cliIsReady)
+        return CLI_STATUS_IDLE;
+    uint16_t remaining = (uint16_t) __HAL_DMA_GET_COUNTER(UART_CLI_PERIPH->hdmarx);
+    embeddedCliSetRxWriteIndex(cli, (uint16_t) (UART_RX_BUFF_SIZE - remaining));
+    return embeddedCliProcess(cli);
+}
+
+// STM32 UART callback function, to send next chunk of CLI output
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart == UART_CLI_PERIPH) {
+        embeddedCliTxConsume(cli, cliTxSending);
+        cliTxBusy = false;
+        startCliTransmit(cli);
     }
 }
 
-// Function to encapsulate the 'embeddedCliPrint()' call with print formatting arguments (act like printf(), but keeps cursor at correct location).
-// The 'embeddedCliPrint()' function does already add a linebreak ('\r\n') to the end of the print statement, so no need to add it yourself.
+// Function to encapsulate the 'embeddedCliPrintf()' call (act like printf(), but keeps cursor at correct location).
+// The 'embeddedCliPrintf()' function does already add a linebreak ('\r\n') to the end of the print statement, so no need to add it yourself.
 void cli_printf(const char *format, ...) {
-    // Create a buffer to store the formatted string
-    char buffer[CLI_PRINT_BUFFER_SIZE];
-
-    // Format the string using snprintf
     va_list args;
     va_start(args, format);
-    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    embeddedCliVPrintf(getCliPointer(), format, args);
     va_end(args);
-
-    // Check if string fitted in buffer else print error to stderr
-    if (length < 0) {
-        fprintf(stderr, "Error formatting the string\r\n");
-        return;
-    }
-
-    // Call embeddedCliPrint with the formatted string
-    embeddedCliPrint(getCliPointer(), buffer);
 }
 
 EmbeddedCli *getCliPointer() {
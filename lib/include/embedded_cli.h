@@ -13,6 +13,8 @@ extern "C" {
 
 // cstdint is available only since C++11, so use C header
 #include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
 
 // used for proper alignment of cli buffer
 #if UINTPTR_MAX == 0xFFFF
@@ -25,6 +27,13 @@ extern "C" {
 #error unsupported pointer size
 #endif
 
+// lets compiler check arguments of printf-like functions
+#if defined(__GNUC__) || defined(__clang__)
+#define CLI_PRINTF_FORMAT(formatIndex, firstArg) __attribute__((format(printf, formatIndex, firstArg)))
+#else
+#define CLI_PRINTF_FORMAT(formatIndex, firstArg)
+#endif
+
 #define CLI_UINT_SIZE (sizeof(CLI_UINT))
 // convert size in bytes to size in terms of CLI_UINTs (rounded up
 // if bytes is not divisible by size of single CLI_UINT)
@@ -36,6 +45,171 @@ typedef struct CliCommandBinding CliCommandBinding;
 typedef struct EmbeddedCli EmbeddedCli;
 typedef struct EmbeddedCliConfig EmbeddedCliConfig;
 
+/**
+ * Defines what happens with output when tx buffer is full and it is drained
+ * externally (via embeddedCliTxPeek and embeddedCliTxConsume)
+ */
+typedef enum EmbeddedCliTxPolicy {
+    /**
+     * Chunk of output (single string or escape sequence) that doesn't fit
+     * into tx buffer is discarded as a whole, so terminal doesn't receive
+     * half of escape sequence
+     */
+    CLI_TX_POLICY_DROP = 0,
+
+    /**
+     * Wait until enough space is freed with embeddedCliTxConsume. Tx buffer
+     * must be drained from ISR or another thread. Chunks of output are put
+     * into buffer only as a whole. If space is not freed during 100 ms
+     * (measured with getTimeMs), chunk and all output after it (until the end
+     * of output transaction) is discarded and embeddedCliEndOutput returns
+     * false. Without getTimeMs cli doesn't wait and chunk that doesn't fit is
+     * discarded as with CLI_TX_POLICY_DROP
+     */
+    CLI_TX_POLICY_BLOCK,
+
+    /**
+     * Chunk of output that doesn't fit into tx buffer and all output after
+     * it (until the end of output transaction) is discarded and
+     * embeddedCliEndOutput returns false
+     */
+    CLI_TX_POLICY_REPORT,
+} EmbeddedCliTxPolicy;
+
+/**
+ * Defines which control sequences are used to update input line on terminal
+ */
+typedef enum EmbeddedCliDialect {
+    /**
+     * VT100 compatible terminal. Only changed part of input line is written
+     * using erase in line, relative cursor moves and char insert/delete
+     */
+    CLI_DIALECT_VT100 = 0,
+
+    /**
+     * Terminal without erase in line support. Input line is cleared by
+     * overwriting it with spaces and then is printed again
+     */
+    CLI_DIALECT_VT100_BASIC,
+
+    /**
+     * Terminal without any escape sequences (logging consoles, simple host
+     * tools). Input line is edited only with \b, spaces and \r, live
+     * autocompletion, status lines and terminal size detection are disabled
+     */
+    CLI_DIALECT_DUMB,
+} EmbeddedCliDialect;
+
+/**
+ * Severity of log messages. Message is printed only when its level is not
+ * greater than log level of its source
+ */
+typedef enum EmbeddedCliLogLevel {
+    /**
+     * Used only as log level to disable all messages
+     */
+    CLI_LOG_NONE = 0,
+    CLI_LOG_ERROR,
+    CLI_LOG_WARNING,
+    CLI_LOG_INFO,
+    CLI_LOG_DEBUG,
+} EmbeddedCliLogLevel;
+
+/**
+ * Can be used in embeddedCliSetLogLevel to change log level of all sources
+ */
+#define CLI_LOG_SOURCE_ALL 0xFFu
+
+/**
+ * Function that produces next chunk of long output (for example, with
+ * embeddedCliPrint). It is called from embeddedCliProcess until it returns
+ * false. Chunk should be small, so it can fit into tx buffer.
+ * @param cli
+ * @param context - context that was given to embeddedCliStartGenerator
+ * @return true if there is more output to produce
+ */
+typedef bool (*EmbeddedCliGenerator)(EmbeddedCli *cli, void *context);
+
+/**
+ * Function that returns current time in microseconds (it can overflow).
+ * Is used to limit time of embeddedCliProcessBudget
+ */
+typedef uint32_t (*EmbeddedCliClock)(EmbeddedCli *cli);
+
+/**
+ * Flags that are returned by embeddedCliProcess and describe work that is
+ * left after processing. When no flags are set, embeddedCliProcess doesn't
+ * need to be called until new input is received (see onRxAvailable)
+ */
+typedef enum EmbeddedCliStatus {
+    CLI_STATUS_IDLE = 0,
+
+    /**
+     * There are unprocessed chars or active generator, embeddedCliProcess
+     * should be called again without waiting
+     */
+    CLI_STATUS_INPUT_PENDING = 0x01,
+
+    /**
+     * Output is waiting in tx buffer until it is drained with
+     * embeddedCliTxPeek and embeddedCliTxConsume
+     */
+    CLI_STATUS_OUTPUT_PENDING = 0x02,
+
+    /**
+     * embeddedCliProcess has to be called after delay that is returned by
+     * embeddedCliGetWakeDelay (for example, to print input line back after
+     * coalesced prints)
+     */
+    CLI_STATUS_TIMER_PENDING = 0x04,
+
+    /**
+     * Messages posted with embeddedCliPostPrint are waiting in print queue,
+     * embeddedCliProcess should be called again without waiting
+     */
+    CLI_STATUS_PRINT_PENDING = 0x08,
+} EmbeddedCliStatus;
+
+/**
+ * Alignment of cells inside table column
+ */
+typedef enum EmbeddedCliAlign {
+    CLI_ALIGN_LEFT = 0,
+    CLI_ALIGN_RIGHT,
+} EmbeddedCliAlign;
+
+typedef struct EmbeddedCliTableColumn {
+    /**
+     * Title that is printed in table header (can be NULL)
+     */
+    const char *title;
+
+    /**
+     * Width of column in chars. Cells are padded to this width, longer cells
+     * are not truncated. Is calculated by embeddedCliPrintTable
+     */
+    uint8_t width;
+
+    EmbeddedCliAlign align;
+} EmbeddedCliTableColumn;
+
+typedef struct EmbeddedCliTable {
+    EmbeddedCliTableColumn *columns;
+
+    uint8_t columnCount;
+} EmbeddedCliTable;
+
+/**
+ * Function that prints single row of table with embeddedCliTableRow. It is
+ * called twice for each row by embeddedCliPrintTable (to measure and to
+ * print), so it must print the same row for the same index.
+ * @param cli
+ * @param table
+ * @param row - index of row to print
+ * @param context - context that was given to embeddedCliPrintTable
+ * @return false if there is no row with given index (nothing is printed)
+ */
+typedef bool (*EmbeddedCliTableRowGenerator)(EmbeddedCli *cli, EmbeddedCliTable *table, uint16_t row, void *context);
 
 struct CliCommand {
     /**
@@ -98,6 +272,58 @@ struct EmbeddedCli {
      */
     void (*writeChar)(EmbeddedCli *cli, char c);
 
+    /**
+     * Optional. Should write buffer of chars to connection. If set, it is used
+     * instead of writeChar, so each string (or whole output between
+     * embeddedCliBeginOutput and embeddedCliEndOutput if tx buffer is enabled)
+     * is sent with a single call.
+     * @param cli - pointer to cli that executed this function
+     * @param buf - chars to write (not null-terminated)
+     * @param len - number of chars to write
+     */
+    void (*writeChars)(EmbeddedCli *cli, const char *buf, size_t len);
+
+    /**
+     * Optional. Called when new output is put into tx buffer and neither
+     * writeChar nor writeChars is set. Can be used to start transfer (for
+     * example, with DMA) that will drain tx buffer with embeddedCliTxPeek
+     * and embeddedCliTxConsume.
+     * @param cli - pointer to cli that executed this function
+     */
+    void (*onTxAvailable)(EmbeddedCli *cli);
+
+    /**
+     * Optional. Called when chars are put to rx buffer by
+     * embeddedCliReceiveChar, embeddedCliReceiveBuffer or
+     * embeddedCliSetRxWriteIndex, so it is usually called from ISR. Should
+     * only signal that embeddedCliProcess has to be called (for example, set
+     * RTOS event flag), so application can sleep while cli is idle.
+     * @param cli          - pointer to cli that executed this function
+     * @param lineComplete - true if received chars contain line break (\r or
+     * \n), so command can be executed
+     */
+    void (*onRxAvailable)(EmbeddedCli *cli, bool lineComplete);
+
+    /**
+     * Optional. Called with true when rx buffer is filled up to
+     * rxHighWatermark and with false when it is processed down to
+     * rxLowWatermark. Can be used for hardware flow control (deassert RTS
+     * while input is throttled). Is called from receiving functions (possibly
+     * ISR) and from embeddedCliProcess.
+     * @param cli      - pointer to cli that executed this function
+     * @param throttle - true if sender should stop sending
+     */
+    void (*onRxThrottle)(EmbeddedCli *cli, bool throttle);
+
+    /**
+     * Optional. Called by embeddedCliPostPrint when message is put into
+     * print queue, so it can be called from ISR or other thread. Like
+     * onRxAvailable, should only signal that embeddedCliProcess has to be
+     * called.
+     * @param cli - pointer to cli that executed this function
+     */
+    void (*onPrintPosted)(EmbeddedCli *cli);
+
     /**
      * Called when command is received and command not found in list of
      * command bindings (or binding function is null).
@@ -106,6 +332,14 @@ struct EmbeddedCli {
      */
     void (*onCommand)(EmbeddedCli *cli, CliCommand *command);
 
+    /**
+     * Optional. Should return current time in milliseconds. Is used to print
+     * timestamps of log messages and to limit rate of log messages.
+     * @param cli - pointer to cli that executed this function
+     * @return time in milliseconds (can overflow)
+     */
+    uint32_t (*getTimeMs)(EmbeddedCli *cli);
+
     /**
      * Can be used for any application context
      */
@@ -128,10 +362,58 @@ struct EmbeddedCliConfig {
     const char *invitation;
     
     /**
-     * Size of buffer that is used to store characters until they're processed
+     * Size of buffer that is used to store characters until they're processed.
+     * If 0, buffer is not taken from cli buffer and circular buffer of
+     * application (like DMA buffer) must be attached with
+     * embeddedCliAttachRxBuffer
      */
     uint16_t rxBufferSize;
 
+    /**
+     * Size of buffer that is used to collect output between
+     * embeddedCliBeginOutput and embeddedCliEndOutput calls, so it can be
+     * written with as few calls to writeChars as possible.
+     * If 0, output is written as soon as it is produced. Size 1 is not
+     * allowed (one char is always kept free, so such buffer is useless).
+     * If writeChar and writeChars are not set, this buffer must be drained
+     * by application with embeddedCliTxPeek and embeddedCliTxConsume
+     */
+    uint16_t txBufferSize;
+
+    /**
+     * What to do with output when tx buffer is drained by application and
+     * there is no space left in it
+     */
+    EmbeddedCliTxPolicy txPolicy;
+
+    /**
+     * Whether software flow control is used. XOFF is sent when rx buffer is
+     * filled up to rxHighWatermark and XON - when it is processed down to
+     * rxLowWatermark. Received XOFF pauses output until XON is received:
+     * output is kept in tx buffer (txPolicy is applied when it doesn't fit),
+     * so tx buffer is required (embeddedCliNew returns NULL without it).
+     * XON and XOFF are never written from receiving side: they are sent
+     * before other output by next processing (or returned first by
+     * embeddedCliTxPeek). So rxHighWatermark must leave space for chars that
+     * are received until next call to embeddedCliProcess plus chars that
+     * sender transmits before it handles XOFF. Use onRxAvailable to process
+     * without delay or onRxThrottle (it is called from receiving side) if
+     * this latency is too high.
+     */
+    bool xonXoff;
+
+    /**
+     * Number of unprocessed chars in rx buffer at which sender is asked to
+     * stop (with XOFF or onRxThrottle). If 0, 3/4 of rx buffer size is used
+     */
+    uint16_t rxHighWatermark;
+
+    /**
+     * Number of unprocessed chars in rx buffer at which sender is allowed to
+     * continue. If 0, 1/4 of rx buffer size is used
+     */
+    uint16_t rxLowWatermark;
+
     /**
      * Size of buffer that is used to store current input that is not yet
      * sended as command (return not pressed yet)
@@ -170,6 +452,121 @@ struct EmbeddedCliConfig {
      * complete current command manually.
      */
     bool enableAutoComplete;
+
+    /**
+     * Control sequences that are supported by terminal. Can be changed later
+     * with embeddedCliSetDialect
+     */
+    EmbeddedCliDialect dialect;
+
+    /**
+     * Initial log level. Messages with greater level are rejected before
+     * they are formatted
+     */
+    EmbeddedCliLogLevel logLevel;
+
+    /**
+     * Number of log sources that have their own log level, name and rate
+     * limit. Messages from other sources use log level that is set for
+     * CLI_LOG_SOURCE_ALL and are not rate limited
+     */
+    uint8_t logSourceCount;
+
+    /**
+     * Maximum number of log messages per second from single source. Messages
+     * above this limit are dropped (and number of dropped messages is printed
+     * later). If 0 or getTimeMs is not set, rate is not limited
+     */
+    uint16_t logRateLimit;
+
+    /**
+     * Maximum number of log messages that can be printed from single source
+     * at once when rate is limited
+     */
+    uint16_t logBurst;
+
+    /**
+     * Whether to print timestamp (from getTimeMs) before each log message
+     */
+    bool logTimestamps;
+
+    /**
+     * Maximum number of messages in queue for embeddedCliPostPrint. Is
+     * rounded down to power of two (from 2 up to 16384). If 0, queue is
+     * disabled
+     */
+    uint16_t printQueueSize;
+
+    /**
+     * Size of single message in print queue (including null-terminator).
+     * Longer messages are truncated
+     */
+    uint16_t printQueueMessageSize;
+
+    /**
+     * Time window (in milliseconds) for coalescing prints. Current command
+     * is printed back only when no print happened during this window (it is
+     * checked in embeddedCliProcess), so burst of prints redraws it only once.
+     * If 0 or getTimeMs is not set, prints are coalesced only inside
+     * print batch
+     */
+    uint16_t printCoalesceMs;
+
+    /**
+     * Width of terminal in chars. Is used to print autocompletion candidates
+     * in columns. If 0, each candidate is printed on separate line.
+     * Can be changed later or detected with embeddedCliRequestTerminalSize
+     */
+    uint16_t terminalWidth;
+
+    /**
+     * Height of terminal in lines. Long listings (help and autocompletion
+     * candidates) are paged with "--More--" prompt: space shows next page,
+     * enter shows next line and q stops listing. If 0, paging is disabled.
+     */
+    uint16_t terminalHeight;
+
+    /**
+     * Maximum time in milliseconds that is spent calling active generator in
+     * single call to embeddedCliProcess. Time is measured with getTimeMs, so
+     * it must be set. If 0, generator is called until it is finished (or
+     * until tx buffer, drained by application, is full).
+     */
+    uint16_t generatorBudgetMs;
+
+    /**
+     * Number of status lines that are pinned at the bottom of terminal (below
+     * scroll region). Status lines are drawn only when terminalHeight is
+     * known. Each line takes statusLineLength + 1 bytes of cli buffer.
+     */
+    uint8_t statusLineCount;
+
+    /**
+     * Maximum length of single status line. Longer texts are truncated.
+     */
+    uint8_t statusLineLength;
+
+    /**
+     * Size of scrollback buffer that records printed output (and executed
+     * commands), so it can be replayed with embeddedCliReplayScrollback.
+     * It is taken from cli buffer. If 0, output is not recorded.
+     */
+    uint16_t scrollbackSize;
+
+    /**
+     * Size of buffer that keeps end of command output for "tail" filter
+     * (only lines that fit into it are printed). It is taken from cli
+     * buffer. If 0, "tail" filter is not available.
+     */
+    uint16_t tailBufferSize;
+
+    /**
+     * Size of buffer for commands executed with embeddedCliCapture (command
+     * is copied there, since it is modified during parsing). Captured
+     * command can be up to captureCommandSize - 2 chars long. It is taken
+     * from cli buffer. If 0, capture is disabled.
+     */
+    uint16_t captureCommandSize;
 };
 
 /**
@@ -180,12 +577,34 @@ struct EmbeddedCliConfig {
  * Default values:
  * <ul>
  * <li>rxBufferSize = 64</li>
+ * <li>txBufferSize = 0</li>
+ * <li>txPolicy = CLI_TX_POLICY_DROP</li>
+ * <li>xonXoff = false</li>
+ * <li>rxHighWatermark = 0</li>
+ * <li>rxLowWatermark = 0</li>
  * <li>cmdBufferSize = 64</li>
  * <li>historyBufferSize = 128</li>
  * <li>cliBuffer = NULL (use dynamic allocation)</li>
  * <li>cliBufferSize = 0</li>
  * <li>maxBindingCount = 8</li>
  * <li>enableAutoComplete = true</li>
+ * <li>dialect = CLI_DIALECT_VT100</li>
+ * <li>logLevel = CLI_LOG_INFO</li>
+ * <li>logSourceCount = 0</li>
+ * <li>logRateLimit = 0</li>
+ * <li>logBurst = 4</li>
+ * <li>logTimestamps = false</li>
+ * <li>printQueueSize = 0</li>
+ * <li>printQueueMessageSize = 64</li>
+ * <li>printCoalesceMs = 0</li>
+ * <li>terminalWidth = 0</li>
+ * <li>terminalHeight = 0</li>
+ * <li>generatorBudgetMs = 0</li>
+ * <li>statusLineCount = 0</li>
+ * <li>statusLineLength = 32</li>
+ * <li>scrollbackSize = 0</li>
+ * <li>tailBufferSize = 0</li>
+ * <li>captureCommandSize = 0</li>
  * </ul>
  * @return configuration for cli creation
  */
@@ -197,7 +616,8 @@ EmbeddedCliConfig *embeddedCliDefaultConfig(void);
  * This amount will always be divisible by CLI_UINT_SIZE so allocated buffer
  * and internal structures can be properly aligned
  * @param config
- * @return
+ * @return required size or 0 if config requires more than 65535 bytes (cli
+ * can't be created with such config)
  */
 uint16_t embeddedCliRequiredSize(EmbeddedCliConfig *config);
 
@@ -227,11 +647,124 @@ EmbeddedCli *embeddedCliNewDefault(void);
  */
 void embeddedCliReceiveChar(EmbeddedCli *cli, char c);
 
+/**
+ * Receive multiple characters and put them to internal buffer. Chars are
+ * copied in bulk, so this is preferred to embeddedCliReceiveChar when data
+ * is received in chunks (DMA, USB, sockets). The same restrictions as for
+ * embeddedCliReceiveChar apply. If not all chars fit into buffer, the rest
+ * is dropped the same way as with embeddedCliReceiveChar (current command
+ * is discarded)
+ * @param cli
+ * @param data - received chars
+ * @param len  - number of received chars
+ * @return number of chars that were put to buffer
+ */
+uint16_t embeddedCliReceiveBuffer(EmbeddedCli *cli, const char *data, uint16_t len);
+
+/**
+ * Use given circular buffer (for example, buffer of DMA in circular mode)
+ * as rx buffer. Chars are processed directly from it, so they are not
+ * copied. Application reports position where next char will be written
+ * with embeddedCliSetRxWriteIndex. embeddedCliReceiveChar and
+ * embeddedCliReceiveBuffer must not be used with attached buffer.
+ * @param cli
+ * @param buf  - circular buffer, it must be valid while cli is used
+ * @param size - size of buffer
+ */
+void embeddedCliAttachRxBuffer(EmbeddedCli *cli, char *buf, uint16_t size);
+
+/**
+ * Report position in attached rx buffer where next char will be written
+ * (for DMA it is buffer size minus remaining transfer count). Chars up to
+ * this position are processed during next embeddedCliProcess call. If
+ * application writes more than size - 1 chars between two calls to
+ * embeddedCliProcess, unprocessed chars are overwritten.
+ * Can be called from ISR
+ * @param cli
+ * @param index - position from 0 to size of attached buffer
+ */
+void embeddedCliSetRxWriteIndex(EmbeddedCli *cli, uint16_t index);
+
 /**
  * Process rx/tx buffers. Command callbacks are called from here
  * @param cli
+ * @return combination of EmbeddedCliStatus flags. CLI_STATUS_IDLE means
+ * that nothing has to be done until new input is received
+ */
+uint8_t embeddedCliProcess(EmbeddedCli *cli);
+
+/**
+ * Get time after which embeddedCliProcess has to be called even if no
+ * input is received (is reported with CLI_STATUS_TIMER_PENDING). Can be
+ * used to set wake up timer before entering sleep
+ * @param cli
+ * @param delayMs - time in milliseconds (measured with getTimeMs), 0 if
+ * embeddedCliProcess should be called now
+ * @return false if there are no pending timers
  */
-void embeddedCliProcess(EmbeddedCli *cli);
+bool embeddedCliGetWakeDelay(EmbeddedCli *cli, uint32_t *delayMs);
+
+/**
+ * Process rx/tx buffers with limited amount of work, so processing can
+ * be called from time critical loop. Processing is stopped when given
+ * number of received chars is processed or given time is spent (checked
+ * after each char, so slow command is not interrupted). State of input
+ * (escape sequences, current command) is kept until next call.
+ * @param cli
+ * @param maxChars  - maximum number of received chars to process (0 for
+ * no limit)
+ * @param maxMicros - maximum processing time in microseconds (0 for no
+ * limit)
+ * @param clock     - function that returns current time in microseconds
+ * (can be NULL if time is not limited)
+ * @return true if there is more work (unprocessed chars or active
+ * generator), so function should be called again soon
+ */
+bool embeddedCliProcessBudget(EmbeddedCli *cli, uint16_t maxChars, uint32_t maxMicros,
+                              EmbeddedCliClock clock);
+
+/**
+ * Begin output transaction. All output that is produced until matching call
+ * to embeddedCliEndOutput is collected inside tx buffer (if it is enabled)
+ * and written with as few calls to writeChars (or writeChar) as possible.
+ * Transactions can be nested, output is written when the outermost one is
+ * ended (or when tx buffer is full).
+ * Processing and printing functions open transaction automatically, so
+ * this is only needed to join output of multiple calls, for example,
+ * several embeddedCliPrint calls.
+ * @param cli
+ */
+void embeddedCliBeginOutput(EmbeddedCli *cli);
+
+/**
+ * End output transaction started with embeddedCliBeginOutput. When the
+ * outermost transaction is ended, all collected output is written.
+ * @param cli
+ * @return false if some output was discarded because tx buffer was full
+ */
+bool embeddedCliEndOutput(EmbeddedCli *cli);
+
+/**
+ * Get chars from tx buffer that are waiting to be sent. Returned chars are
+ * stored contiguously, so they can be sent directly (for example, with DMA).
+ * Chars are not removed from tx buffer until embeddedCliTxConsume is called.
+ * Pending flow control char (XON or XOFF) is returned first as a separate
+ * chunk. Can be called from ISR, but only from single place.
+ * @param cli
+ * @param data - will be set to pointer to first char
+ * @param len - will be set to number of chars that can be sent
+ * @return true if there are chars to send
+ */
+bool embeddedCliTxPeek(EmbeddedCli *cli, const char **data, uint16_t *len);
+
+/**
+ * Remove given number of chars from tx buffer after they were sent.
+ * Count must not be greater than length returned by embeddedCliTxPeek.
+ * Can be called from ISR, but only from single place.
+ * @param cli
+ * @param count - number of chars that were sent
+ */
+void embeddedCliTxConsume(EmbeddedCli *cli, uint16_t count);
 
 /**
  * Add specified binding to list of bindings. If list is already full, binding
@@ -242,6 +775,23 @@ void embeddedCliProcess(EmbeddedCli *cli);
  */
 bool embeddedCliAddBinding(EmbeddedCli *cli, CliCommandBinding binding);
 
+/**
+ * Execute given command (the same way as if it was entered by user) and
+ * collect its output into given buffer instead of writing it. Command is not
+ * echoed or put to history and current input line is not redrawn. Output
+ * of generator started by command is collected before return. Can be called
+ * from binding, but not from command that is captured.
+ * @param cli
+ * @param command - command with arguments (output filter can be added)
+ * @param buf - buffer for output, it is not null-terminated
+ * @param capacity - size of buf
+ * @param length - number of chars written to buf
+ * @return false if output didn't fit into buf (it is truncated) or command
+ * can't be executed
+ */
+bool embeddedCliCapture(EmbeddedCli *cli, const char *command,
+                        char *buf, uint16_t capacity, uint16_t *length);
+
 /**
  * Print specified string and account for currently entered but not submitted
  * command.
@@ -252,6 +802,246 @@ bool embeddedCliAddBinding(EmbeddedCli *cli, CliCommandBinding binding);
  */
 void embeddedCliPrint(EmbeddedCli *cli, const char *string);
 
+/**
+ * Same as embeddedCliPrint but prints formatted string. String is formatted
+ * directly to output, so no intermediate buffer is used and stdio is not
+ * required. Line break is added at the end automatically.
+ * Supported format is %[flags][width][.precision][length]specifier where:
+ * <ul>
+ * <li>flags: '-' (left align), '0' (pad numbers with zeros)</li>
+ * <li>width: number or '*'</li>
+ * <li>precision: number or '*', used only to limit length of strings</li>
+ * <li>length: 'l' for long, 'z' for size_t, 'h' for short, 'hh' for char</li>
+ * <li>specifier: d, i, u, x, X, c, s, p or %</li>
+ * </ul>
+ * Floating point values (f, e, g, a) and 'll' length are not supported: such
+ * specifier is printed as is and its argument is skipped.
+ * @param cli
+ * @param format
+ * @param ...
+ */
+void embeddedCliPrintf(EmbeddedCli *cli, const char *format, ...) CLI_PRINTF_FORMAT(2, 3);
+
+/**
+ * Same as embeddedCliPrintf but takes arguments as va_list
+ * @param cli
+ * @param format
+ * @param args
+ */
+void embeddedCliVPrintf(EmbeddedCli *cli, const char *format, va_list args) CLI_PRINTF_FORMAT(2, 0);
+
+/**
+ * Print header of table: titles of columns and line of dashes below them
+ * @param cli
+ * @param table
+ */
+void embeddedCliTableHeader(EmbeddedCli *cli, EmbeddedCliTable *table);
+
+/**
+ * Print single row of table. Format is the same as in embeddedCliPrintf,
+ * each conversion is a cell of next column: it is padded to column width
+ * according to column alignment and cells are separated with two spaces.
+ * Cells are written directly to output without intermediate buffers.
+ * Format should contain only conversions, other text is written as is.
+ * Example: embeddedCliTableRow(cli, &table, "%s%u%08lx", name, count, reg);
+ * @param cli
+ * @param table
+ * @param format
+ * @param ...
+ */
+void embeddedCliTableRow(EmbeddedCli *cli, EmbeddedCliTable *table, const char *format, ...)
+CLI_PRINTF_FORMAT(3, 4);
+
+/**
+ * Same as embeddedCliTableRow but takes arguments as va_list
+ * @param cli
+ * @param table
+ * @param format
+ * @param args
+ */
+void embeddedCliVTableRow(EmbeddedCli *cli, EmbeddedCliTable *table, const char *format, va_list args)
+CLI_PRINTF_FORMAT(3, 0);
+
+/**
+ * Print table with automatic column widths. Generator is called for all rows
+ * twice: first to measure cells (nothing is printed), then to print them
+ * after header. Widths of columns are replaced by calculated ones.
+ * @param cli
+ * @param table
+ * @param generator - prints row with given index
+ * @param context - will be passed to generator
+ */
+void embeddedCliPrintTable(EmbeddedCli *cli, EmbeddedCliTable *table,
+                           EmbeddedCliTableRowGenerator generator, void *context);
+
+/**
+ * Print recently recorded output again (for example, when terminal is
+ * reconnected). Only whole lines are printed. Scrollback must be enabled
+ * in config.
+ * @param cli
+ * @param bytes - maximum number of recorded chars to print (0 to print all)
+ */
+void embeddedCliReplayScrollback(EmbeddedCli *cli, uint16_t bytes);
+
+/**
+ * Begin print batch. Current command is removed from screen by the first
+ * print inside batch and is printed back only once when batch is ended, so
+ * prints are written back-to-back. Batches can be nested. If new input is
+ * processed inside batch, current command is printed back before it.
+ * @param cli
+ */
+void embeddedCliBeginPrintBatch(EmbeddedCli *cli);
+
+/**
+ * End print batch started with embeddedCliBeginPrintBatch. When outermost
+ * batch is ended, current command is printed back (if it was removed)
+ * @param cli
+ */
+void embeddedCliEndPrintBatch(EmbeddedCli *cli);
+
+/**
+ * Put copy of specified string into print queue. All queued strings are
+ * printed (the same way as with embeddedCliPrint) during next call to
+ * embeddedCliProcess, current command is redrawn only once for all of them.
+ * Unlike other functions, this one can be called from any thread or ISR
+ * concurrently, queue is lock-free. Print queue must be enabled in config
+ * @param cli
+ * @param string - string to print, truncated to printQueueMessageSize - 1
+ * @return false if queue is full or disabled (string is not printed)
+ */
+bool embeddedCliPostPrint(EmbeddedCli *cli, const char *string);
+
+/**
+ * Print log message with given level from given source. Message is rejected
+ * before formatting if its level is greater than log level of the source.
+ * Message is printed the same way as with embeddedCliPrintf and is prefixed
+ * with timestamp (if enabled), level and source name (if set). Format is the
+ * same as in embeddedCliPrintf.
+ * @param cli
+ * @param level - level of message (must not be CLI_LOG_NONE)
+ * @param source - index of log source
+ * @param format
+ * @param ...
+ */
+void embeddedCliLog(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source, const char *format, ...)
+CLI_PRINTF_FORMAT(4, 5);
+
+/**
+ * Same as embeddedCliLog but takes arguments as va_list
+ * @param cli
+ * @param level
+ * @param source
+ * @param format
+ * @param args
+ */
+void embeddedCliVLog(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source,
+                     const char *format, va_list args) CLI_PRINTF_FORMAT(4, 0);
+
+/**
+ * Check whether message with given level from given source will be printed.
+ * Can be used to skip expensive preparation of log arguments
+ * @param cli
+ * @param level
+ * @param source
+ * @return true if message will be printed (unless it is rate limited)
+ */
+bool embeddedCliIsLogEnabled(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source);
+
+/**
+ * Change log level of given source. If source is CLI_LOG_SOURCE_ALL, level
+ * is changed for all sources, including sources that are not counted in
+ * logSourceCount
+ * @param cli
+ * @param source - index of log source or CLI_LOG_SOURCE_ALL
+ * @param level
+ */
+void embeddedCliSetLogLevel(EmbeddedCli *cli, uint8_t source, EmbeddedCliLogLevel level);
+
+/**
+ * Set name of given log source. Name is printed before each message from this
+ * source and is used in "log-level" command. Source must be less than
+ * logSourceCount in config
+ * @param cli
+ * @param source
+ * @param name - name of source (without spaces), must be valid while cli exists
+ */
+void embeddedCliSetLogSourceName(EmbeddedCli *cli, uint8_t source, const char *name);
+
+/**
+ * Add "log-level" command that shows and changes log levels at runtime.
+ * Command uses one of bindings, so maxBindingCount in config should
+ * account for it.
+ * @param cli
+ * @return true if command was added
+ */
+bool embeddedCliAddLogLevelBinding(EmbeddedCli *cli);
+
+/**
+ * Change text of status line. Only chars that differ from currently displayed
+ * text are written (cursor is moved there and back), so frequent updates of
+ * live values are cheap and don't affect input line.
+ * @param cli
+ * @param index - index of status line (0 is the topmost one)
+ * @param text
+ * @return false if there is no status line with given index
+ */
+bool embeddedCliSetStatusLine(EmbeddedCli *cli, uint8_t index, const char *text);
+
+/**
+ * Show or update progress indicator on current line. Can be used only while
+ * command is executed (from binding or generator), since input line is not
+ * displayed then. Only changed cells of indicator are written. Printed lines
+ * appear above indicator. Indicator is left on screen when command output
+ * is finished.
+ * @param cli
+ * @param percent - value from 0 to 100
+ * @return false if indicator can't be shown now
+ */
+bool embeddedCliShowProgress(EmbeddedCli *cli, uint8_t percent);
+
+/**
+ * Remove progress indicator from screen
+ * @param cli
+ */
+void embeddedCliHideProgress(EmbeddedCli *cli);
+
+/**
+ * Start producing long output with given generator. Generator is called from
+ * embeddedCliProcess while there is enough space in tx buffer (when it is
+ * drained by application) and time budget is not exceeded. Until generator
+ * is finished, received chars are kept in rx buffer and invitation is not
+ * printed. Usually is called from command binding.
+ * @param cli
+ * @param generator
+ * @param context - will be passed to generator
+ * @return false if other generator is already active
+ */
+bool embeddedCliStartGenerator(EmbeddedCli *cli, EmbeddedCliGenerator generator, void *context);
+
+/**
+ * Set size of terminal that is used to layout and page long listings
+ * @param cli
+ * @param width - width in chars (0 to print one item per line)
+ * @param height - height in lines (0 to disable paging)
+ */
+void embeddedCliSetTerminalSize(EmbeddedCli *cli, uint16_t width, uint16_t height);
+
+/**
+ * Ask terminal to report its size. Cursor is moved to the bottom right corner
+ * and its position is requested, then cursor is returned back. Terminal size
+ * is updated when response is received in embeddedCliProcess. Terminal must
+ * support VT100 cursor position report.
+ * @param cli
+ */
+void embeddedCliRequestTerminalSize(EmbeddedCli *cli);
+
+/**
+ * Change control sequences that are used to update input line on terminal
+ * @param cli
+ * @param dialect
+ */
+void embeddedCliSetDialect(EmbeddedCli *cli, EmbeddedCliDialect dialect);
+
 /**
  * Free allocated for cli memory
  * @param cli
@@ -1,17 +1,25 @@
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "embedded_cli.h"
 
 #define CLI_TOKEN_NPOS 0xffff
 
+/**
+ * Size of buffer that is enough to store any unsigned long or pointer value
+ * converted to decimal or hexadecimal string (without null-terminator)
+ */
+#define CLI_NUMBER_BUFFER_SIZE \
+  ((sizeof(unsigned long) > sizeof(uintptr_t) ? sizeof(unsigned long) : sizeof(uintptr_t)) * 3)
+
 #ifndef UNUSED
 #define UNUSED(x) (void)x
 #endif
 
+// implementation is always placed right after EmbeddedCli in cli buffer, so
+// its address is calculated instead of loading _impl pointer
 #define PREPARE_IMPL(t) \
-  EmbeddedCliImpl* impl = (EmbeddedCliImpl*)t->_impl
+  EmbeddedCliImpl* impl = (EmbeddedCliImpl*)((CLI_UINT*)(t) + BYTES_TO_CLI_UINTS(sizeof(EmbeddedCli)))
 
 #define IS_FLAG_SET(flags, flag) (((flags) & (flag)) != 0)
 
@@ -19,18 +27,52 @@
 
 #define UNSET_U8FLAG(flags, flag) ((flags) &= (uint8_t) ~(flag))
 
+#define UNSET_U16FLAG(flags, flag) ((flags) &= (uint16_t) ~(flag))
+
+/*
+ * Atomic operations on uint16_t values that are shared between threads and
+ * ISRs. GCC and clang builtins are used by default. With MSVC volatile
+ * accesses (which have acquire/release semantics there) and interlocked
+ * compare-and-swap are used. For other compilers these macros can be
+ * defined before implementation is included, otherwise plain volatile
+ * accesses are used, which are safe only when producers can't interrupt
+ * each other.
+ */
+#ifndef CLI_ATOMIC_LOAD
+#if defined(__GNUC__) || defined(__clang__)
+#define CLI_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define CLI_ATOMIC_LOAD_RELAXED(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define CLI_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#define CLI_ATOMIC_CAS(ptr, expected, desired) \
+  __atomic_compare_exchange_n((ptr), (expected), (desired), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+#define CLI_ATOMIC_FALLBACK
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#define CLI_ATOMIC_LOAD(ptr) (*(volatile uint16_t *) (ptr))
+#define CLI_ATOMIC_LOAD_RELAXED(ptr) (*(volatile uint16_t *) (ptr))
+#define CLI_ATOMIC_STORE(ptr, value) (*(volatile uint16_t *) (ptr) = (value))
+#define CLI_ATOMIC_CAS(ptr, expected, desired) atomicCasFallback((ptr), (expected), (desired))
+#endif
+#endif
+
+/*
+ * Output can be bound at compile time by defining EMBEDDED_CLI_WRITE_CHAR(c)
+ * and/or EMBEDDED_CLI_WRITE_CHARS(buf, len) before implementation is
+ * included. Then writeChar and writeChars callbacks are not used and write
+ * (for example, to UART data register) can be inlined.
+ */
+#if defined(EMBEDDED_CLI_WRITE_CHAR) || defined(EMBEDDED_CLI_WRITE_CHARS)
+#define CLI_STATIC_OUTPUT
+#endif
+
 /**
  * Marks binding as candidate for autocompletion
  * This flag is updated each time getAutocompletedCommand is called
  */
 #define BINDING_FLAG_AUTOCOMPLETE 1u
 
-/**
- * Indicates that rx buffer overflow happened. In such case last command
- * that wasn't finished (no \r or \n were received) will be discarded
- */
-#define CLI_FLAG_OVERFLOW 0x01u
-
 /**
  * Indicates that initialization is completed. Initialization is completed in
  * first call to process and needed, for example, to print invitation message.
@@ -44,9 +86,9 @@
 #define CLI_FLAG_ALLOCATED 0x04u
 
 /**
- * Indicates that escape mode is enabled.
+ * Indicates that printed text is passed through output filter line by line
  */
-#define CLI_FLAG_ESCAPE_MODE 0x08u
+#define CLI_FLAG_FILTERING 0x08u
 
 /**
  * Indicates that CLI in mode when it will print directly to output without
@@ -59,6 +101,96 @@
  */
 #define CLI_FLAG_AUTOCOMPLETE_ENABLED 0x20u
 
+/**
+ * Indicates that some output was discarded because tx buffer was full
+ */
+#define CLI_FLAG_TX_OVERFLOW 0x40u
+
+/**
+ * Indicates that autocompletion for current command is stored in cache and
+ * bindings don't need to be checked again
+ */
+#define CLI_FLAG_AUTOCOMPLETE_CACHED 0x80u
+
+/**
+ * Indicates that current command was removed from screen by print and is not
+ * printed back yet because prints are coalesced
+ */
+#define CLI_FLAG_INPUT_HIDDEN 0x100u
+
+/**
+ * Indicates that scroll region is set and status lines are drawn at the
+ * bottom of terminal
+ */
+#define CLI_FLAG_STATUS_AREA 0x200u
+
+/**
+ * Indicates that progress indicator is drawn on current line
+ */
+#define CLI_FLAG_PROGRESS_SHOWN 0x400u
+
+/**
+ * Indicates that output is recorded to scrollback
+ */
+#define CLI_FLAG_RECORDING 0x800u
+
+/**
+ * Indicates that output is not written but matched against grep pattern
+ */
+#define CLI_FLAG_MATCHING 0x1000u
+
+/**
+ * Indicates that line that will be printed next matched grep pattern
+ */
+#define CLI_FLAG_LINE_MATCHED 0x2000u
+
+/**
+ * Indicates that none of currently printed text is written because of
+ * output filter (it is still passed to filter to count its lines)
+ */
+#define CLI_FLAG_SUPPRESSED 0x4000u
+
+/**
+ * Indicates that output is collected into capture buffer
+ */
+#define CLI_FLAG_CAPTURING 0x8000u
+
+/**
+ * Flags that require output to be processed before it is written
+ */
+#define CLI_FLAGS_OUTPUT_PROCESSED (CLI_FLAG_RECORDING | CLI_FLAG_MATCHING | CLI_FLAG_FILTERING | \
+                                    CLI_FLAG_CAPTURING)
+
+/**
+ * Maximum time to wait for free space in tx buffer with block policy
+ */
+#define CLI_TX_BLOCK_TIMEOUT_MS 100u
+
+/**
+ * Flow control char that resumes transmission (DC1, Ctrl-Q)
+ */
+#define CLI_XON 0x11
+
+/**
+ * Flow control char that pauses transmission (DC3, Ctrl-S)
+ */
+#define CLI_XOFF 0x13
+
+/**
+ * Number of lines that head and tail filters pass when number is not given
+ */
+#define CLI_FILTER_DEFAULT_LINES 10
+
+/**
+ * Number of cells in progress bar
+ */
+#define CLI_PROGRESS_BAR_WIDTH 20
+
+/**
+ * Length of progress indicator: "[####......]  40%"
+ */
+#define CLI_PROGRESS_LENGTH (CLI_PROGRESS_BAR_WIDTH + 7)
+
 /**
 * Indicates that cursor direction should be forward
 */
@@ -73,7 +205,83 @@ typedef struct EmbeddedCliImpl EmbeddedCliImpl;
 typedef struct AutocompletedCommand AutocompletedCommand;
 typedef struct FifoBuf FifoBuf;
 typedef struct CliHistory CliHistory;
+typedef struct LogSource LogSource;
+typedef struct PrintQueue PrintQueue;
+typedef struct Pager Pager;
+typedef struct Scrollback Scrollback;
+typedef struct OutputFilter OutputFilter;
+typedef struct Capture Capture;
+typedef struct ProcessBudget ProcessBudget;
+
+/**
+ * Listings that can be printed page by page
+ */
+typedef enum PagerContent {
+    PAGER_NONE = 0,
+    PAGER_HELP,
+    PAGER_CANDIDATES,
+} PagerContent;
+
+/**
+ * Filters that can be applied to command output with pipe suffix
+ */
+typedef enum OutputFilterType {
+    FILTER_NONE = 0,
+    FILTER_GREP,
+    FILTER_HEAD,
+    FILTER_TAIL,
+    FILTER_COUNT,
+} OutputFilterType;
+
+/**
+ * State of input parser
+ */
+typedef enum InputState {
+    INPUT_STATE_NORMAL = 0,
+    /**
+     * Escape char was received
+     */
+    INPUT_STATE_ESCAPE,
+    /**
+     * Control sequence (\e[) is received, parameters are collected until
+     * final char
+     */
+    INPUT_STATE_CSI,
+    /**
+     * Single shift (\eO) is received, next char selects the key
+     */
+    INPUT_STATE_SS3,
+} InputState;
+
+/**
+ * Editing keys that are received as control chars or escape sequences
+ */
+typedef enum InputKey {
+    INPUT_KEY_NONE = 0,
+    INPUT_KEY_ENTER,
+    INPUT_KEY_BACKSPACE,
+    INPUT_KEY_TAB,
+    INPUT_KEY_ESCAPE,
+    INPUT_KEY_UP,
+    INPUT_KEY_DOWN,
+    INPUT_KEY_RIGHT,
+    INPUT_KEY_LEFT,
+    INPUT_KEY_HOME,
+    INPUT_KEY_END,
+    INPUT_KEY_DELETE,
+    INPUT_KEY_WORD_RIGHT,
+    INPUT_KEY_WORD_LEFT,
+    INPUT_KEY_KILL_LINE_END,
+    INPUT_KEY_KILL_LINE_START,
+    INPUT_KEY_KILL_WORD,
+} InputKey;
 
+/**
+ * Single producer single consumer ring buffer. Producer (that pushes chars)
+ * and consumer (that takes them) can run in different threads or ISRs: each
+ * of them modifies only its own position and publishes it with release
+ * store after chars are copied
+ */
 struct FifoBuf {
     char *buf;
     /**
@@ -88,6 +296,11 @@ struct FifoBuf {
      * Size of buffer
      */
     uint16_t size;
+    /**
+     * size - 1 if size is a power of two (positions are wrapped with mask),
+     * 0 otherwise
+     */
+    uint16_t mask;
 };
 
 struct CliHistory {
@@ -115,802 +328,3783 @@ struct CliHistory {
     uint16_t itemsCount;
 };
 
-struct EmbeddedCliImpl {
+struct AutocompletedCommand {
     /**
-     * Invitation string. Is printed at the beginning of each line with user
-     * input
+     * Name of autocompleted command (or first candidate for autocompletion if
+     * there are multiple candidates).
+     * NULL if autocomplete not possible.
      */
-    const char *invitation;
-
-    CliHistory history;
+    const char *firstCandidate;
 
     /**
-     * Buffer for storing received chars.
-     * Chars are stored in FIFO mode.
+     * Number of characters that can be completed safely. For example, if there
+     * are two possible commands "get-led" and "get-adc", then for prefix "g"
+     * autocompletedLen will be 4. If there are only one candidate, this number
+     * is always equal to length of the command.
      */
-    FifoBuf rxBuffer;
+    uint16_t autocompletedLen;
 
     /**
-     * Buffer for current command
+     * Total number of candidates for autocompletion
      */
-    char *cmdBuffer;
+    uint16_t candidateCount;
+};
 
+struct LogSource {
     /**
-     * Size of current command
+     * Name of source that is printed before each message. Can be NULL
      */
-    uint16_t cmdSize;
+    const char *name;
 
     /**
-     * Total size of command buffer
+     * Time when tokens were refilled last time
      */
-    uint16_t cmdMaxSize;
+    uint32_t lastRefillMs;
 
-    CliCommandBinding *bindings;
+    /**
+     * Number of messages that can be printed before next refill
+     */
+    uint16_t tokens;
 
     /**
-     * Flags for each binding. Sizes are the same as for bindings array
+     * Number of messages that were dropped because of rate limit since last
+     * printed message
      */
-    uint8_t *bindingsFlags;
+    uint16_t droppedCount;
 
-    uint16_t bindingsCount;
+    EmbeddedCliLogLevel level;
+};
 
-    uint16_t maxBindingsCount;
+/**
+ * Bounded lock-free queue of messages. Each message slot has sequence number
+ * that tells whether slot is free for producer with given position or
+ * contains message for consumer with given position. Producers reserve slots
+ * by advancing enqueuePos with compare-and-swap, single consumer (process)
+ * takes messages in order of reservation.
+ */
+struct PrintQueue {
+    /**
+     * Text of messages, each message takes messageSize chars
+     */
+    char *messages;
 
     /**
-     * Total length of input line. This doesn't include invitation but
-     * includes current command and its live autocompletion
+     * Sequence number for each message slot
      */
-    uint16_t inputLineLength;
+    uint16_t *sequences;
 
     /**
-     * Stores last character that was processed.
+     * Position of next slot to reserve. Shared between producers
      */
-    char lastChar;
+    uint16_t enqueuePos;
 
     /**
-     * Flags are defined as CLI_FLAG_*
+     * Position of next message to print. Used only by consumer
      */
-    uint8_t flags;
+    uint16_t dequeuePos;
 
     /**
-     * Cursor position for current command from right to left 
-     * 0 = end of command
+     * Number of slots minus one (number of slots is power of two)
      */
-    uint16_t cursorPos;
+    uint16_t mask;
+
+    uint16_t messageSize;
 };
 
-struct AutocompletedCommand {
+/**
+ * Ring buffer with recent printed output. When it is full, oldest output
+ * is overwritten
+ */
+struct Scrollback {
+    char *buf;
+
+    uint16_t size;
+
     /**
-     * Name of autocompleted command (or first candidate for autocompletion if
-     * there are multiple candidates).
-     * NULL if autocomplete not possible.
+     * Position where next char is written
      */
-    const char *firstCandidate;
+    uint16_t head;
 
     /**
-     * Number of characters that can be completed safely. For example, if there
-     * are two possible commands "get-led" and "get-adc", then for prefix "g"
-     * autocompletedLen will be 4. If there are only one candidate, this number
-     * is always equal to length of the command.
+     * Number of recorded chars (up to size)
      */
-    uint16_t autocompletedLen;
+    uint16_t length;
 
     /**
-     * Total number of candidates for autocompletion
+     * Whether oldest recorded char starts a line. Is false when beginning
+     * of oldest line is overwritten
      */
-    uint16_t candidateCount;
+    bool lineStart;
 };
 
-static EmbeddedCliConfig defaultConfig;
-
 /**
- * Number of commands that cli adds. Commands:
- * - help
+ * State of built-in listing (help or autocompletion candidates). Listing is
+ * printed by generator item by item and can be paused with "--More--" prompt
+ * until user presses a key
  */
-static const uint16_t cliInternalBindingCount = 1;
+struct Pager {
+    PagerContent content;
 
-static const char *lineBreak = "\r\n";
+    /**
+     * Whether listing is paused and waits for user input
+     */
+    bool waiting;
 
-/* References for VT100 escape sequences: 
- * https://learn.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences 
- * https://ecma-international.org/publications-and-standards/standards/ecma-48/
+    /**
+     * Index of binding that will be printed next
+     */
+    uint16_t nextBinding;
+
+    /**
+     * Width of single column (used for candidates)
+     */
+    uint16_t columnWidth;
+
+    /**
+     * Number of items in single line (used for candidates)
+     */
+    uint16_t columns;
+
+    /**
+     * Number of lines that were printed on current page
+     */
+    uint16_t pageLinesPrinted;
+
+    /**
+     * Number of lines that can be printed before listing is paused
+     */
+    uint16_t pageLines;
+};
+
+/**
+ * Filter of command output that is installed with pipe suffix (like
+ * "dump | grep err"). Output is split into lines by line breaks, so
+ * multi-line prints are counted correctly. Grep checks each print as a
+ * whole, tail keeps last lines in its own ring, so filter works in constant
+ * memory
  */
+struct OutputFilter {
+    OutputFilterType type;
 
-/** Escape sequence - Cursor forward (right) */
-static const char *escSeqCursorRight = "\x1B[C";
+    /**
+     * Pattern of grep filter. '*' matches any sequence of chars, pattern
+     * is matched anywhere inside line. Points into command buffer
+     */
+    const char *pattern;
 
-/** Escape sequence - Cursor backward (left) */
-static const char *escSeqCursorLeft = "\x1B[D";
+    /**
+     * Number of lines for head and tail filters
+     */
+    uint16_t limit;
 
-/** Escape sequence - Cursor save position */
-static const char *escSeqCursorSave = "\x1B[s";
+    /**
+     * Number of line breaks that command printed so far
+     */
+    uint16_t lines;
 
-/** Escape sequence - Cursor restore position */
-static const char *escSeqCursorRestore = "\x1B[u";
+    /**
+     * Position in pattern where currently matched segment (part between
+     * '*') starts
+     */
+    uint16_t segment;
 
-/** Escape sequence - Cursor insert character (ICH) */
-static const char *escSeqInsertChar = "\x1B[@";
+    /**
+     * Number of chars of current segment that match end of printed text
+     */
+    uint16_t matched;
 
-/** Escape sequence - Cursor delete character (DCH) */
-static const char *escSeqDeleteChar = "\x1B[P";
+    /**
+     * Whether whole pattern is found in current line
+     */
+    bool found;
+};
 
 /**
- * Navigate through command history back and forth. If navigateUp is true,
- * navigate to older commands, otherwise navigate to newer.
- * When history end is reached, nothing happens.
- * @param cli
- * @param navigateUp
+ * State of command execution with embeddedCliCapture
  */
-static void navigateHistory(EmbeddedCli *cli, bool navigateUp);
+struct Capture {
+    /**
+     * Copy of captured command, that is modified during parsing
+     */
+    char *command;
 
-/**
- * Process escaped character. After receiving ESC+[ sequence, all chars up to
- * ending character are sent to this function
- * @param cli
- * @param c
- */
-static void onEscapedInput(EmbeddedCli *cli, char c);
+    uint16_t commandSize;
 
-/**
- * Process input character. Character is valid displayable char and should be
- * added to current command string and displayed to client.
- * @param cli
- * @param c
- */
-static void onCharInput(EmbeddedCli *cli, char c);
+    /**
+     * Buffer provided by application, where output is collected
+     */
+    char *buf;
 
-/**
- * Process control character (like \r or \n) possibly altering state of current
- * command or executing onCommand callback.
- * @param cli
- * @param c
- */
-static void onControlInput(EmbeddedCli *cli, char c);
+    uint16_t capacity;
 
-/**
- * Parse command in buffer and execute callback
- * @param cli
- */
-static void parseCommand(EmbeddedCli *cli);
+    uint16_t length;
 
-/**
- * Print help for given binding (if it is set)
- * @param binding
- */
-static void printBindingHelp(EmbeddedCli *cli, CliCommandBinding *binding);
+    /**
+     * Whether some output didn't fit into buffer
+     */
+    bool truncated;
+};
 
 /**
- * Setup bindings for internal commands, like help
- * @param cli
+ * Limits of work that is done in single call to embeddedCliProcessBudget
  */
-static void initInternalBindings(EmbeddedCli *cli);
+struct ProcessBudget {
+    /**
+     * Number of chars that can be processed, 0 if not limited
+     */
+    uint16_t maxChars;
 
-/**
- * Show help for given tokens (or default help if no tokens)
+    uint16_t chars;
+
+    /**
+     * Time in microseconds that can be spent, 0 if not limited
+     */
+    uint32_t maxMicros;
+
+    uint32_t startMicros;
+
+    EmbeddedCliClock clock;
+};
+
+struct EmbeddedCliImpl {
+    /**
+     * Invitation string. Is printed at the beginning of each line with user
+     * input
+     */
+    const char *invitation;
+
+    CliHistory history;
+
+    /**
+     * Buffer for storing received chars.
+     * Chars are stored in FIFO mode.
+     */
+    FifoBuf rxBuffer;
+
+    /**
+     * Buffer for collecting output inside output transaction.
+     * Is not used (size is 0) if tx buffer is disabled.
+     */
+    FifoBuf txBuffer;
+
+    /**
+     * Policy for handling full tx buffer when it is drained by application
+     */
+    EmbeddedCliTxPolicy txPolicy;
+
+    /**
+     * Whether XON/XOFF flow control is used
+     */
+    bool xonXoff;
+
+    /**
+     * Watermarks of rx buffer fill for input throttling (0 for default)
+     */
+    uint16_t rxHighWatermark;
+
+    uint16_t rxLowWatermark;
+
+    /**
+     * Non-zero while sender is asked to stop (XOFF is sent or onRxThrottle
+     * is called). Is set when chars are received and cleared by processing
+     */
+    uint16_t rxThrottled;
+
+    /**
+     * Non-zero if rx buffer overflow happened. In such case last command
+     * that wasn't finished (no \r or \n were received) will be discarded.
+     * Is set from receiving side (possibly ISR), so it is kept out of flags
+     */
+    uint16_t rxOverflow;
+
+    /**
+     * Non-zero while output is paused by received XOFF
+     */
+    uint16_t txPaused;
+
+    /**
+     * Flow control char (XON or XOFF) that is waiting to be sent before any
+     * other output, 0 if there is none. Is set from receiving side and
+     * cleared when char is written or consumed from tx peek
+     */
+    uint16_t txControlChar;
+
+    /**
+     * Copy of flow control char returned by embeddedCliTxPeek, 0 if it was
+     * not peeked
+     */
+    char txControlPeeked;
+
+    /**
+     * Buffer for current command
+     */
+    char *cmdBuffer;
+
+    /**
+     * Size of current command
+     */
+    uint16_t cmdSize;
+
+    /**
+     * Total size of command buffer
+     */
+    uint16_t cmdMaxSize;
+
+    CliCommandBinding *bindings;
+
+    /**
+     * Flags for each binding. Sizes are the same as for bindings array
+     */
+    uint8_t *bindingsFlags;
+
+    uint16_t bindingsCount;
+
+    uint16_t maxBindingsCount;
+
+    /**
+     * Total length of input line. This doesn't include invitation but
+     * includes current command and its live autocompletion
+     */
+    uint16_t inputLineLength;
+
+    /**
+     * Name of command that was used to print live autocompletion. Chars of
+     * this name from cmdSize up to inputLineLength are currently displayed
+     * after command. NULL if displayed chars are unknown.
+     */
+    const char *liveAutocompletion;
+
+    /**
+     * Autocompletion for current command. Valid only when
+     * CLI_FLAG_AUTOCOMPLETE_CACHED is set
+     */
+    AutocompletedCommand autocompletion;
+
+    /**
+     * Stores last character that was processed.
+     */
+    char lastChar;
+
+    /**
+     * Whether bracketed paste is in progress (between \e[200~ and \e[201~).
+     * Pasted text is inserted as is: tab is not autocompleted and line break
+     * executes command without autocompletion
+     */
+    bool pasting;
+
+    /**
+     * Flags are defined as CLI_FLAG_*
+     */
+    uint16_t flags;
+
+    /**
+     * Cursor position for current command from right to left 
+     * 0 = end of command
+     */
+    uint16_t cursorPos;
+
+    /**
+     * Depth of nested output transactions. Output is collected in tx buffer
+     * while it is greater than zero
+     */
+    uint8_t outputDepth;
+
+    /**
+     * Control sequences that are supported by terminal
+     */
+    EmbeddedCliDialect dialect;
+
+    /**
+     * Log level of sources that are not in logSources
+     */
+    EmbeddedCliLogLevel logLevel;
+
+    /**
+     * Sources with individual log level and rate limit
+     */
+    LogSource *logSources;
+
+    uint8_t logSourceCount;
+
+    /**
+     * Maximum number of log messages per second from single source
+     */
+    uint16_t logRateLimit;
+
+    /**
+     * Maximum number of tokens of single log source
+     */
+    uint16_t logBurst;
+
+    bool logTimestamps;
+
+    /**
+     * Messages posted with embeddedCliPostPrint. Disabled if messages is NULL
+     */
+    PrintQueue printQueue;
+
+    /**
+     * Recent printed output. Disabled if size is 0
+     */
+    Scrollback scrollback;
+
+    /**
+     * Last lines of command output for tail filter. Disabled if size is 0
+     */
+    Scrollback tailLines;
+
+    /**
+     * Filter of current command output
+     */
+    OutputFilter filter;
+
+    Capture capture;
+
+    /**
+     * Depth of nested print batches. Current command is not printed back
+     * while it is greater than zero
+     */
+    uint8_t printBatchDepth;
+
+    /**
+     * Time during which prints are coalesced after last print
+     */
+    uint16_t printCoalesceMs;
+
+    /**
+     * Time of last print (used only when prints are coalesced by time)
+     */
+    uint32_t lastPrintMs;
+
+    /**
+     * Size of terminal in chars. 0 if unknown
+     */
+    uint16_t terminalWidth;
+
+    uint16_t terminalHeight;
+
+    /**
+     * Generator that produces output of current command. NULL if there is
+     * no active generator
+     */
+    EmbeddedCliGenerator generator;
+
+    /**
+     * Table whose rows are currently measured by embeddedCliPrintTable.
+     * Rows of this table are not printed
+     */
+    EmbeddedCliTable *measuredTable;
+
+    void *generatorContext;
+
+    /**
+     * Maximum number of chars that single call to generator produced. Next
+     * call is made only when there is enough space in tx buffer
+     */
+    uint16_t generatorMaxChunk;
+
+    /**
+     * Time during which generator can be called in single process call
+     */
+    uint16_t generatorBudgetMs;
+
+    /**
+     * Total number of chars written to output (can overflow). Is used to
+     * measure output of generator
+     */
+    uint16_t outputCount;
+
+    /**
+     * State of current built-in listing
+     */
+    Pager pager;
+
+    /**
+     * Texts of status lines that are currently displayed. Each line takes
+     * statusLineLength + 1 chars
+     */
+    char *statusLines;
+
+    uint8_t statusLineCount;
+
+    uint8_t statusLineLength;
+
+    /**
+     * Number of lines that screen content is already scrolled up by to free
+     * space for status lines
+     */
+    uint8_t statusLinesScrolled;
+
+    /**
+     * Value of progress indicator that is currently displayed
+     */
+    uint8_t progress;
+
+    /**
+     * State of input parser (whether escape sequence is being received)
+     */
+    InputState inputState;
+
+    /**
+     * Numeric parameters of escape sequence that is being received
+     */
+    uint16_t escParams[2];
+
+    uint8_t escParamIndex;
+};
+
+static EmbeddedCliConfig defaultConfig;
+
+/**
+ * Number of commands that cli adds. Commands:
+ * - help
+ */
+static const uint16_t cliInternalBindingCount = 1;
+
+static const char *lineBreak = "\r\n";
+
+/* References for VT100 escape sequences: 
+ * https://learn.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences 
+ * https://ecma-international.org/publications-and-standards/standards/ecma-48/
+ */
+
+/** Escape sequence - Cursor forward (right) */
+static const char *escSeqCursorRight = "\x1B[C";
+
+/** Escape sequence - Cursor backward (left) */
+static const char *escSeqCursorLeft = "\x1B[D";
+
+/** Escape sequence - Cursor save position */
+static const char *escSeqCursorSave = "\x1B[s";
+
+/** Escape sequence - Cursor restore position */
+static const char *escSeqCursorRestore = "\x1B[u";
+
+/** Escape sequence - Cursor insert character (ICH) */
+static const char *escSeqInsertChar = "\x1B[@";
+
+/** Escape sequence - Cursor delete character (DCH) */
+static const char *escSeqDeleteChar = "\x1B[P";
+
+/** Escape sequence - Erase from cursor to the end of line (EL) */
+static const char *escSeqEraseLine = "\x1B[K";
+
+/**
+ * Keys of C0 control chars (0x00-0x1F), indexed by char. Emacs style line
+ * editing shortcuts are supported, 0x7F is treated as backspace separately
+ */
+static const uint8_t controlCharKeys[32] = {
+        // NUL, ^A, ^B, ^C
+        INPUT_KEY_NONE, INPUT_KEY_HOME, INPUT_KEY_LEFT, INPUT_KEY_NONE,
+        // ^D, ^E, ^F, ^G
+        INPUT_KEY_DELETE, INPUT_KEY_END, INPUT_KEY_RIGHT, INPUT_KEY_NONE,
+        // \b, \t, \n, ^K
+        INPUT_KEY_BACKSPACE, INPUT_KEY_TAB, INPUT_KEY_ENTER, INPUT_KEY_KILL_LINE_END,
+        // ^L, \r, ^N, ^O
+        INPUT_KEY_NONE, INPUT_KEY_ENTER, INPUT_KEY_DOWN, INPUT_KEY_NONE,
+        // ^P, ^Q, ^R, ^S
+        INPUT_KEY_UP, INPUT_KEY_NONE, INPUT_KEY_NONE, INPUT_KEY_NONE,
+        // ^T, ^U, ^V, ^W
+        INPUT_KEY_NONE, INPUT_KEY_KILL_LINE_START, INPUT_KEY_NONE, INPUT_KEY_KILL_WORD,
+        // ^X, ^Y, ^Z, ESC
+        INPUT_KEY_NONE, INPUT_KEY_NONE, INPUT_KEY_NONE, INPUT_KEY_ESCAPE,
+        // FS, GS, RS, US
+        INPUT_KEY_NONE, INPUT_KEY_NONE, INPUT_KEY_NONE, INPUT_KEY_NONE,
+};
+
+/** Escape sequence - Move cursor far to bottom right and report its position */
+static const char *escSeqRequestSize = "\x1B[999;999H\x1B[6n";
+
+/** Shown when listing is paused by pager */
+static const char *pagerPrompt = "--More--";
+
+/** Cursor backward (left) with backspace, shorter than escape sequence */
+static const char *cursorLeftBackspace = "\b";
+
+/** Names of log levels, indexed by EmbeddedCliLogLevel */
+static const char *logLevelNames[] = {"none", "error", "warning", "info", "debug"};
+
+/** Short names of log levels that are printed before log messages */
+static const char *logLevelLetters = "-EWID";
+
+/** Used to pad formatted values with multiple chars at once */
+static const char *paddingSpaces = "        ";
+static const char *paddingZeros = "00000000";
+static const char *paddingDashes = "--------";
+
+/** Written between cells of table */
+static const char *tableSeparator = "  ";
+
+/**
+ * Navigate through command history back and forth. If navigateUp is true,
+ * navigate to older commands, otherwise navigate to newer.
+ * When history end is reached, nothing happens.
  * @param cli
- * @param tokens
- * @param context - not used
+ * @param navigateUp
  */
-static void onHelp(EmbeddedCli *cli, char *tokens, void *context);
+static void navigateHistory(EmbeddedCli *cli, bool navigateUp);
+
+/**
+ * Process escaped character. After receiving ESC, all chars up to the end of
+ * sequence (final char of CSI or SS3 sequence) are sent to this function
+ * @param cli
+ * @param c
+ * @return false if char is not part of escape sequence and should be
+ * processed as regular input
+ */
+static bool onEscapedInput(EmbeddedCli *cli, char c);
+
+/**
+ * Get key that is selected by final char of CSI or SS3 sequence and received
+ * parameters
+ * @param cli
+ * @param c - final char
+ * @return
+ */
+static InputKey getSequenceKey(EmbeddedCli *cli, char c);
+
+/**
+ * Process editing key
+ * @param cli
+ * @param key
+ */
+static void onKeyInput(EmbeddedCli *cli, InputKey key);
+
+/**
+ * Move cursor inside current command to given position. Cursor is moved on
+ * screen with single sequence (or by printing passed chars)
+ * @param cli
+ * @param cursorPos - new position from the end of command
+ */
+static void setCursorPos(EmbeddedCli *cli, uint16_t cursorPos);
+
+/**
+ * Get position of word boundary next to cursor. Words are separated by spaces
+ * @param cli
+ * @param forward - if true, end of next word is searched, otherwise start of
+ * previous word
+ * @return position from the end of command
+ */
+static uint16_t getWordBoundary(EmbeddedCli *cli, bool forward);
+
+/**
+ * Remove given number of chars after cursor from current command and from
+ * screen
+ * @param cli
+ * @param count
+ */
+static void removeChars(EmbeddedCli *cli, uint16_t count);
+
+/**
+ * Process input character. Character is valid displayable char and should be
+ * added to current command string and displayed to client.
+ * @param cli
+ * @param c
+ */
+static void onCharInput(EmbeddedCli *cli, char c);
+
+/**
+ * Process input character together with displayable chars that are already
+ * waiting in rx buffer (pasted text). All chars are appended to the end of
+ * current command and echoed with single write.
+ * @param cli
+ * @param budget - appended chars are counted in budget
+ * @param c - first char of run
+ * @return last processed char
+ */
+static char onCharRunInput(EmbeddedCli *cli, ProcessBudget *budget, char c);
+
+/**
+ * Take received char for processing if budget is not spent yet
+ * @param cli
+ * @param budget
+ * @param c - taken char
+ * @return false if there are no chars or budget is spent
+ */
+static bool takeInputChar(EmbeddedCli *cli, ProcessBudget *budget, char *c);
+
+/**
+ * Process control character (like \r or \n) possibly altering state of current
+ * command or executing onCommand callback. Char is translated to key by
+ * controlCharKeys table.
+ * @param cli
+ * @param c
+ */
+static void onControlInput(EmbeddedCli *cli, char c);
+
+/**
+ * Execute current command (after trying to autocomplete it) and start new
+ * input line
+ * @param cli
+ */
+static void submitCommand(EmbeddedCli *cli);
+
+/**
+ * Parse command in buffer and execute callback
+ * @param cli
+ */
+static void parseCommand(EmbeddedCli *cli);
+
+/**
+ * Split command into name and args and execute its binding (or onCommand
+ * callback). Command is modified during parsing
+ * @param cli
+ * @param buffer - command, there must be two more chars available after it
+ * @param size - length of command
+ */
+static void executeCommand(EmbeddedCli *cli, char *buffer, uint16_t size);
+
+/**
+ * Copy given chars to capture buffer. Chars that don't fit are dropped
+ * @param cli
+ * @param buf
+ * @param len
+ */
+static void captureChars(EmbeddedCli *cli, const char *buf, size_t len);
+
+/**
+ * Prepare for printing text that is not part of input line. Current command
+ * is removed from screen (unless cli is executing command) and output
+ * transaction is started
+ * @param cli
+ */
+static void beginPrint(EmbeddedCli *cli);
+
+/**
+ * Finish printing started with beginPrint. Line break is printed and
+ * current command is printed back to screen (unless cli is executing command
+ * or prints are coalesced)
+ * @param cli
+ */
+static void endPrint(EmbeddedCli *cli);
+
+/**
+ * Print invitation, current command and live autocompletion back to screen
+ * after they were removed by print
+ * @param cli
+ */
+static void restoreInputLine(EmbeddedCli *cli);
+
+/**
+ * Returns true if prints are coalesced during time window after last print
+ * @param cli
+ * @return
+ */
+static bool isCoalesceWindowEnabled(EmbeddedCli *cli);
+
+/**
+ * Set scroll region above status lines and draw all status lines. Is called
+ * when terminal height becomes known or is changed
+ * @param cli
+ */
+static void setupStatusArea(EmbeddedCli *cli);
+
+/**
+ * Write part of status line that differs from currently displayed text.
+ * Cursor is returned to its position after drawing
+ * @param cli
+ * @param index - index of status line
+ * @param text - new text of status line
+ * @param redraw - if true, whole line is written
+ */
+static void drawStatusLine(EmbeddedCli *cli, uint8_t index, const char *text, bool redraw);
+
+/**
+ * Write progress indicator with given value to buffer
+ * @param buffer - buffer of at least CLI_PROGRESS_LENGTH chars
+ * @param percent
+ */
+static void formatProgress(char *buffer, uint8_t percent);
+
+/**
+ * Remove progress indicator from current line. It is drawn again when
+ * print is finished
+ * @param cli
+ */
+static void clearProgress(EmbeddedCli *cli);
+
+/**
+ * Leave progress indicator on screen and move to next line. Is called when
+ * command output is finished
+ * @param cli
+ */
+static void finishProgress(EmbeddedCli *cli);
+
+/**
+ * Parse pipe suffix of command (like "| grep err") into given filter.
+ * Suffix is removed from command
+ * @param cli
+ * @param buffer - command
+ * @param size - length of command, is updated when suffix is removed
+ * @param filter - filter to fill. Type is FILTER_NONE if there is no suffix
+ * @return false if suffix is invalid (error is printed)
+ */
+static bool parseFilter(EmbeddedCli *cli, char *buffer, uint16_t *size, OutputFilter *filter);
+
+/**
+ * Start matching of printed line against grep pattern. While matching,
+ * output is not written
+ * @param cli
+ * @return true if grep filter is active and printed text should be written
+ * for matching (and then printed again if it matches)
+ */
+static bool beginLineMatch(EmbeddedCli *cli);
+
+/**
+ * Finish matching started with beginLineMatch. Line is printed only if it
+ * matched
+ * @param cli
+ */
+static void endLineMatch(EmbeddedCli *cli);
+
+/**
+ * Feed given chars to grep pattern matcher
+ * @param filter
+ * @param buf
+ * @param len
+ */
+static void matchChars(OutputFilter *filter, const char *buf, size_t len);
+
+/**
+ * Check whether text that is about to be printed can be passed by active
+ * output filter. If none of it can, CLI_FLAG_SUPPRESSED is set
+ * @param cli
+ * @return true if filter is active and printed text should be passed
+ * through it
+ */
+static bool applyFilter(EmbeddedCli *cli);
+
+/**
+ * Pass printed chars through active output filter line by line: count line
+ * breaks, keep lines for tail and write lines that are passed
+ * @param cli
+ * @param buf
+ * @param len
+ */
+static void filterOutput(EmbeddedCli *cli, const char *buf, size_t len);
+
+/**
+ * Print result of output filter (number of lines or last lines) and remove
+ * filter. Is called when command output is finished
+ * @param cli
+ */
+static void finishFilter(EmbeddedCli *cli);
+
+/**
+ * Append given chars to scrollback ring, overwriting oldest output when it
+ * is full
+ * @param scrollback
+ * @param buf
+ * @param len
+ */
+static void scrollbackAppend(Scrollback *scrollback, const char *buf, size_t len);
+
+/**
+ * Print whole lines from the end of scrollback ring as single print
+ * @param cli
+ * @param scrollback
+ * @param bytes - maximum number of chars to print (0 for no limit)
+ * @param lines - maximum number of lines to print (0 for no limit)
+ */
+static void printScrollback(EmbeddedCli *cli, Scrollback *scrollback, uint16_t bytes, uint16_t lines);
+
+/**
+ * Write formatted string directly to output. See embeddedCliPrintf for
+ * supported format
+ * @param cli
+ * @param format
+ * @param args
+ */
+static void formatToOutput(EmbeddedCli *cli, const char *format, va_list args);
+
+/**
+ * Write formatted string to output, each conversion is written as cell of
+ * given table (aligned and padded to column width)
+ * @param cli
+ * @param format
+ * @param args
+ * @param table - table to use for cells or NULL to write string as is
+ * @param measure - if true, nothing is written, only column widths are
+ * extended to fit cells
+ */
+static void formatCells(EmbeddedCli *cli, const char *format, va_list args,
+                        EmbeddedCliTable *table, bool measure);
+
+/**
+ * Print all messages that are currently in print queue. Current command is
+ * cleared and printed back only once for all messages
+ * @param cli
+ */
+static void processPrintQueue(EmbeddedCli *cli);
+
+/**
+ * Get number of slots in print queue for given config
+ * @param config
+ * @return size rounded down to power of two (at least 2) or 0 if queue is
+ * disabled
+ */
+static uint16_t getPrintQueueSize(EmbeddedCliConfig *config);
+
+/**
+ * Returns true if there is published message in print queue that is not
+ * printed yet
+ * @param cli
+ * @return
+ */
+static bool isPrintQueued(EmbeddedCli *cli);
+
+/**
+ * Get size of cli buffer required for given config. Size is calculated in
+ * 32bit, so it can be checked against 16bit limit of cli buffer
+ * @param config
+ * @return
+ */
+static uint32_t getRequiredSize(EmbeddedCliConfig *config);
+
+#ifdef CLI_ATOMIC_FALLBACK
+/**
+ * Compare-and-swap without builtins from compiler. Is atomic only with MSVC,
+ * otherwise works only when producers can't interrupt each other
+ * @param ptr
+ * @param expected - updated with current value if it is not equal
+ * @param desired
+ * @return true if value was replaced
+ */
+static bool atomicCasFallback(uint16_t *ptr, uint16_t *expected, uint16_t desired);
+#endif
+
+/**
+ * Write formatted string directly to output. Works like formatToOutput but
+ * takes variable number of arguments
+ * @param cli
+ * @param format
+ * @param ...
+ */
+static void writeFormatted(EmbeddedCli *cli, const char *format, ...);
+
+/**
+ * Write given char to output multiple times
+ * @param cli
+ * @param c - char to write (space, zero or dash)
+ * @param count
+ */
+static void writePadding(EmbeddedCli *cli, char c, size_t count);
+
+/**
+ * Convert unsigned value to string with given base. Digits are written to
+ * provided buffer without null-terminator
+ * @param buffer - buffer of at least CLI_NUMBER_BUFFER_SIZE chars
+ * @param value
+ * @param base - 10 or 16
+ * @param upperCase - whether to use upper case letters for hex digits
+ * @return number of written digits
+ */
+static uint8_t formatUnsigned(char *buffer, unsigned long value, uint8_t base, bool upperCase);
+
+/**
+ * Convert pointer value to hexadecimal string with all significant digits
+ * (pointer can be wider than unsigned long). Digits are written to provided
+ * buffer without null-terminator
+ * @param buffer - buffer of at least CLI_NUMBER_BUFFER_SIZE chars
+ * @param value
+ * @return number of written digits
+ */
+static uint8_t formatPointer(char *buffer, uintptr_t value);
+
+/**
+ * Print help for given binding (if it is set)
+ * @param binding
+ */
+static void printBindingHelp(EmbeddedCli *cli, CliCommandBinding *binding);
+
+/**
+ * Setup bindings for internal commands, like help
+ * @param cli
+ */
+static void initInternalBindings(EmbeddedCli *cli);
+
+/**
+ * Show help for given tokens (or default help if no tokens)
+ * @param cli
+ * @param tokens
+ * @param context - not used
+ */
+static void onHelp(EmbeddedCli *cli, char *tokens, void *context);
+
+/**
+ * Show error about unknown command
+ * @param cli
+ * @param name
+ */
+static void onUnknownCommand(EmbeddedCli *cli, const char *name);
+
+/**
+ * Show or change log levels depending on given tokens
+ * @param cli
+ * @param tokens
+ * @param context - not used
+ */
+static void onLogLevel(EmbeddedCli *cli, char *tokens, void *context);
+
+/**
+ * Print log levels of all sources
+ * @param cli
+ */
+static void printLogLevels(EmbeddedCli *cli);
+
+/**
+ * Find log source by its name or index
+ * @param cli
+ * @param name - name or decimal index of source
+ * @return index of source or CLI_LOG_SOURCE_ALL if not found
+ */
+static uint8_t findLogSource(EmbeddedCli *cli, const char *name);
+
+/**
+ * Find log level by its name
+ * @param name
+ * @param level - will be set to found level
+ * @return true if level was found
+ */
+static bool parseLogLevel(const char *name, EmbeddedCliLogLevel *level);
+
+/**
+ * Refill tokens of log source according to elapsed time and take one token
+ * for new message. Always succeeds when rate is not limited
+ * @param cli
+ * @param source
+ * @return true if message can be printed
+ */
+static bool takeLogToken(EmbeddedCli *cli, LogSource *source);
+
+/**
+ * Write timestamp, level and name of source before log message
+ * @param cli
+ * @param level
+ * @param source - can be NULL
+ */
+static void writeLogPrefix(EmbeddedCli *cli, EmbeddedCliLogLevel level, LogSource *source);
+
+/**
+ * Return autocompleted command for given prefix.
+ * Prefix is compared to all known command bindings and autocompleted result
+ * is returned
+ * @param cli
+ * @param prefix
+ * @return
+ */
+static AutocompletedCommand getAutocompletedCommand(EmbeddedCli *cli, const char *prefix);
+
+/**
+ * Return autocompleted command for current command. Result is cached, so
+ * bindings are checked only after current command or bindings are changed.
+ * @param cli
+ * @return
+ */
+static AutocompletedCommand getCurrentAutocompletion(EmbeddedCli *cli);
+
+/**
+ * Prints autocompletion result while keeping current command unchanged
+ * Only chars that differ from already displayed autocompletion are printed.
+ * @param cli
+ */
+static void printLiveAutocompletion(EmbeddedCli *cli);
+
+/**
+ * Handles autocomplete request. If autocomplete possible - fills current
+ * command with autocompleted command. When multiple commands satisfy entered
+ * prefix, they are printed to output.
+ * @param cli
+ * @param allowPaging - whether list of candidates can be paused by pager
+ */
+static void onAutocompleteRequest(EmbeddedCli *cli, bool allowPaging);
+
+/**
+ * Start printing given listing. If paging is allowed, listing is printed by
+ * generator (so it can be paused by pager), otherwise it is printed at once
+ * @param cli
+ * @param content
+ * @param allowPaging - if false, whole listing is printed at once
+ * @return true if whole listing was printed
+ */
+static bool startListing(EmbeddedCli *cli, PagerContent content, bool allowPaging);
+
+/**
+ * Generator that prints single item of current listing per call and pauses
+ * listing when page is full
+ * @param cli
+ * @param context - not used
+ * @return true if there are more items to print
+ */
+static bool listingGenerator(EmbeddedCli *cli, void *context);
+
+/**
+ * Print single item of current listing (help for binding or a line of
+ * candidates)
+ * @param cli
+ * @param binding - index of first binding of this item
+ * @return index of binding after printed item
+ */
+static uint16_t printListingItem(EmbeddedCli *cli, uint16_t binding);
+
+/**
+ * Get number of lines that are printed for listing item
+ * @param cli
+ * @param binding - index of first binding of this item
+ * @return
+ */
+static uint16_t getListingItemLines(EmbeddedCli *cli, uint16_t binding);
+
+/**
+ * Find next binding that is included into current listing
+ * @param cli
+ * @param binding - index to start from
+ * @return index of binding or bindingsCount if there are no more bindings
+ */
+static uint16_t getNextListingBinding(EmbeddedCli *cli, uint16_t binding);
+
+/**
+ * Process char while pager is waiting for user input
+ * @param cli
+ * @param c
+ */
+static void onPagerInput(EmbeddedCli *cli, char c);
+
+/**
+ * Call active generator while there is enough space in tx buffer and time
+ * budget is not exceeded. When generator is finished, invitation and current
+ * command are printed
+ * @param cli
+ */
+static void runGenerator(EmbeddedCli *cli);
+
+/**
+ * Remove pager prompt from screen
+ * @param cli
+ */
+static void erasePagerPrompt(EmbeddedCli *cli);
+
+/**
+ * Removes all input from current line (with erase in line or by replacing it
+ * with whitespaces) and places cursor at the beginning of the line
+ * @param cli
+ */
+static void clearCurrentLine(EmbeddedCli *cli);
+
+/**
+ * Replace current command with given text. When supported by terminal, only
+ * part of input line that differs from current command is written
+ * Cursor is placed at the end of new command
+ * @param cli
+ * @param text
+ */
+static void replaceCommand(EmbeddedCli *cli, const char *text);
+
+/**
+ * Returns true if terminal supports erase in line and relative cursor moves
+ * so input line can be updated partially
+ * @param cli
+ * @return
+ */
+static bool isPartialRedrawSupported(EmbeddedCli *cli);
+
+/**
+ * Returns true if terminal supports escape sequences. Otherwise input line
+ * is edited only with \b, spaces and \r
+ * @param cli
+ * @return
+ */
+static bool isEscSeqSupported(EmbeddedCli *cli);
+
+/**
+ * Write given string to cli output
+ * @param cli
+ * @param str
+ */
+static void writeToOutput(EmbeddedCli *cli, const char *str);
+
+/**
+ * Write given chars to cli output. If output transaction is active and tx
+ * buffer is enabled, chars are collected in tx buffer, otherwise they are
+ * written immediately
+ * @param cli
+ * @param buf
+ * @param len
+ */
+static void writeCharsToOutput(EmbeddedCli *cli, const char *buf, size_t len);
+
+/**
+ * Write single char to cli output
+ * @param cli
+ * @param c
+ */
+static void writeCharToOutput(EmbeddedCli *cli, char c);
+
+/**
+ * Write given chars directly to connection with writeChars (or writeChar if
+ * writeChars is not set)
+ * @param cli
+ * @param buf
+ * @param len
+ */
+static void emitChars(EmbeddedCli *cli, const char *buf, size_t len);
+
+/**
+ * Write everything that is collected in tx buffer to connection
+ * @param cli
+ */
+static void flushOutput(EmbeddedCli *cli);
+
+/**
+ * Put given chars into tx buffer that is drained by application. When there
+ * is not enough space, chars are handled according to tx policy
+ * @param cli
+ * @param buf
+ * @param len
+ */
+static void queueOutput(EmbeddedCli *cli, const char *buf, size_t len);
+
+/**
+ * Wait until application consumes enough chars from tx buffer. Waiting
+ * time is limited by CLI_TX_BLOCK_TIMEOUT_MS (getTimeMs must be set)
+ * @param cli
+ * @param required - number of chars that must fit into tx buffer
+ * @return false if space was not freed during timeout
+ */
+static bool waitTxSpace(EmbeddedCli *cli, uint16_t required);
+
+/**
+ * Returns true if tx buffer is drained by application instead of writing
+ * its contents with writeChar or writeChars
+ * @param cli
+ * @return
+ */
+static bool isTxDrainedExternally(EmbeddedCli *cli);
+
+/**
+ * Returns true if cli has any way to write its output
+ * @param cli
+ * @return
+ */
+static bool isOutputAvailable(EmbeddedCli *cli);
+
+/**
+ * Move cursor forward (right) by given number of positions
+ * @param cli
+ * @param count
+ * @param direction: true = forward (right), false = backward (left)
+ */
+static void moveCursor(EmbeddedCli* cli, uint16_t count, bool direction);
+
+/**
+ * Write escape sequence with numeric parameter
+ * @param cli
+ * @param escSeq - sequence without parameter, like \e[D
+ * @param count - parameter to insert before final char
+ */
+static void writeCountedEscSeq(EmbeddedCli *cli, const char *escSeq, uint16_t count);
+
+/**
+ * Returns true if provided char is a valid displayable character:
+ * a-z, A-Z, 0-9, whitespace, punctuation, etc.
+ * Currently only ASCII is supported
+ * @param c
+ * @return
+ */
+static bool isDisplayableChar(char c);
+
+/**
+ * Check chars that were put to rx buffer. Received XOFF pauses output and
+ * XON resumes it (if XON/XOFF flow control is enabled)
+ * @param cli
+ * @param data
+ * @param len
+ * @return true if chars contain \r or \n
+ */
+static bool scanReceivedChars(EmbeddedCli *cli, const char *data, uint16_t len);
+
+/**
+ * Throttle input if rx buffer is filled up to high watermark and notify
+ * application about received chars
+ * @param cli
+ * @param lineComplete - whether received chars contain line break
+ */
+static void onCharsReceived(EmbeddedCli *cli, bool lineComplete);
+
+/**
+ * Ask sender to stop or to continue sending (by XOFF/XON and onRxThrottle).
+ * Nothing is done if input is already in requested state
+ * @param cli
+ * @param throttled
+ */
+static void setRxThrottled(EmbeddedCli *cli, bool throttled);
+
+/**
+ * Get fill of rx buffer at which input is throttled
+ * @param cli
+ * @return
+ */
+static uint16_t getRxHighWatermark(EmbeddedCli *cli);
+
+/**
+ * Initialize empty fifo buffer of given size
+ * @param buffer
+ * @param size
+ */
+static void fifoBufInit(FifoBuf *buffer, uint16_t size);
+
+/**
+ * Wrap position that went past the end of buffer. Division is not used
+ * @param buffer
+ * @param pos - position less than 2 * size
+ * @return position inside buffer
+ */
+static uint16_t fifoBufWrap(FifoBuf *buffer, uint32_t pos);
+
+/**
+ * How many elements are currently available in buffer
+ * @param buffer
+ * @return number of elements
+ */
+static uint16_t fifoBufAvailable(FifoBuf *buffer);
+
+/**
+ * Return first character from buffer and remove it from buffer
+ * Buffer must be non-empty, otherwise 0 is returned
+ * @param buffer
+ * @return
+ */
+static char fifoBufPop(FifoBuf *buffer);
+
+/**
+ * Push character into fifo buffer. If there is no space left, character is
+ * discarded and false is returned
+ * @param buffer
+ * @param a - character to add
+ * @return true if char was added to buffer, false otherwise
+ */
+static bool fifoBufPush(FifoBuf *buffer, char a);
+
+/**
+ * Push as many chars from provided array into fifo buffer as possible.
+ * Chars are copied with at most two calls to memcpy
+ * @param buffer
+ * @param data - chars to add
+ * @param len - number of chars to add
+ * @return number of chars that were added to buffer
+ */
+static uint16_t fifoBufPushBuffer(FifoBuf *buffer, const char *data, uint16_t len);
+
+/**
+ * Get pointer to the first element in buffer and number of elements that are
+ * stored contiguously starting from it
+ * @param buffer
+ * @param data - will be set to pointer to first element
+ * @return number of contiguous elements (0 if buffer is empty)
+ */
+static uint16_t fifoBufPeek(FifoBuf *buffer, const char **data);
+
+/**
+ * Remove given number of elements from the front of buffer
+ * Count must not be greater than number of available elements
+ * @param buffer
+ * @param count
+ */
+static void fifoBufConsume(FifoBuf *buffer, uint16_t count);
+
+/**
+ * Copy provided string to the history buffer.
+ * If it is already inside history, it will be removed from it and added again.
+ * So after addition, it will always be on top
+ * If available size is not enough (and total size is enough) old elements will
+ * be removed from history so this item can be put to it
+ * @param history
+ * @param str
+ * @return true if string was put in history
+ */
+static bool historyPut(CliHistory *history, const char *str);
+
+/**
+ * Get item from history. Items are counted from 1 so if item is 0 or greater
+ * than itemCount, NULL is returned
+ * @param history
+ * @param item
+ * @return true if string was put in history
+ */
+static const char *historyGet(CliHistory *history, uint16_t item);
+
+/**
+ * Remove specific item from history
+ * @param history
+ * @param str - string to remove
+ * @return
+ */
+static void historyRemove(CliHistory *history, const char *str);
+
+/**
+ * Return position (index of first char) of specified token
+ * @param tokenizedStr - tokenized string (separated by \0 with
+ * \0\0 at the end)
+ * @param pos - token position (counted from 1)
+ * @return index of first char of specified token
+ */
+static uint16_t getTokenPosition(const char *tokenizedStr, uint16_t pos);
+
+EmbeddedCliConfig *embeddedCliDefaultConfig(void) {
+    defaultConfig.rxBufferSize = 64;
+    defaultConfig.txBufferSize = 0;
+    defaultConfig.txPolicy = CLI_TX_POLICY_DROP;
+    defaultConfig.xonXoff = false;
+    defaultConfig.rxHighWatermark = 0;
+    defaultConfig.rxLowWatermark = 0;
+    defaultConfig.cmdBufferSize = 64;
+    defaultConfig.historyBufferSize = 128;
+    defaultConfig.cliBuffer = NULL;
+    defaultConfig.cliBufferSize = 0;
+    defaultConfig.maxBindingCount = 8;
+    defaultConfig.enableAutoComplete = true;
+    defaultConfig.invitation = "> ";
+    defaultConfig.dialect = CLI_DIALECT_VT100;
+    defaultConfig.logLevel = CLI_LOG_INFO;
+    defaultConfig.logSourceCount = 0;
+    defaultConfig.logRateLimit = 0;
+    defaultConfig.logBurst = 4;
+    defaultConfig.logTimestamps = false;
+    defaultConfig.printQueueSize = 0;
+    defaultConfig.printQueueMessageSize = 64;
+    defaultConfig.printCoalesceMs = 0;
+    defaultConfig.terminalWidth = 0;
+    defaultConfig.terminalHeight = 0;
+    defaultConfig.generatorBudgetMs = 0;
+    defaultConfig.statusLineCount = 0;
+    defaultConfig.statusLineLength = 32;
+    defaultConfig.scrollbackSize = 0;
+    defaultConfig.tailBufferSize = 0;
+    defaultConfig.captureCommandSize = 0;
+    return &defaultConfig;
+}
+
+uint16_t embeddedCliRequiredSize(EmbeddedCliConfig *config) {
+    uint32_t totalSize = getRequiredSize(config);
+    return totalSize > UINT16_MAX ? 0 : (uint16_t) totalSize;
+}
+
+EmbeddedCli *embeddedCliNew(EmbeddedCliConfig *config) {
+    EmbeddedCli *cli = NULL;
+
+    uint32_t requiredSize = getRequiredSize(config);
+    if (requiredSize > UINT16_MAX)
+        return NULL;
+
+    // one slot of tx buffer is always kept empty, so buffer of single char
+    // can't hold any output
+    if (config->txBufferSize == 1)
+        return NULL;
+
+    // output paused by XOFF is kept in tx buffer, so it is required
+    if (config->xonXoff && config->txBufferSize == 0)
+        return NULL;
+
+    uint16_t bindingCount = (uint16_t) (config->maxBindingCount + cliInternalBindingCount);
+    uint16_t printQueueSize = getPrintQueueSize(config);
+
+    size_t totalSize = requiredSize;
+
+    bool allocated = false;
+    if (config->cliBuffer == NULL) {
+        config->cliBuffer = (CLI_UINT *) malloc(totalSize); // malloc guarantees alignment.
+        if (config->cliBuffer == NULL)
+            return NULL;
+        allocated = true;
+    } else if (config->cliBufferSize < totalSize) {
+        return NULL;
+    }
+
+    CLI_UINT *buf = config->cliBuffer;
+
+    memset(buf, 0, totalSize);
+
+    cli = (EmbeddedCli *) buf;
+    buf += BYTES_TO_CLI_UINTS(sizeof(EmbeddedCli));
+
+    cli->_impl = (EmbeddedCliImpl *) buf;
+    buf += BYTES_TO_CLI_UINTS(sizeof(EmbeddedCliImpl));
+
+    PREPARE_IMPL(cli);
+    impl->rxBuffer.buf = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->rxBufferSize * sizeof(char));
+
+    if (config->txBufferSize > 0)
+        impl->txBuffer.buf = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->txBufferSize * sizeof(char));
+
+    impl->cmdBuffer = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->cmdBufferSize * sizeof(char));
+
+    impl->bindings = (CliCommandBinding *) buf;
+    buf += BYTES_TO_CLI_UINTS(bindingCount * sizeof(CliCommandBinding));
+
+    impl->bindingsFlags = (uint8_t *) buf;
+    buf += BYTES_TO_CLI_UINTS(bindingCount);
+
+    impl->logSources = (LogSource *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->logSourceCount * sizeof(LogSource));
+
+    if (printQueueSize > 0) {
+        impl->printQueue.sequences = (uint16_t *) buf;
+        buf += BYTES_TO_CLI_UINTS(printQueueSize * sizeof(uint16_t));
+        impl->printQueue.messages = (char *) buf;
+        buf += BYTES_TO_CLI_UINTS(printQueueSize * config->printQueueMessageSize * sizeof(char));
+    }
+
+    impl->statusLines = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->statusLineCount * (config->statusLineLength + 1u) * sizeof(char));
+
+    impl->scrollback.buf = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->scrollbackSize * sizeof(char));
+
+    impl->tailLines.buf = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->tailBufferSize * sizeof(char));
+
+    impl->capture.command = (char *) buf;
+    buf += BYTES_TO_CLI_UINTS(config->captureCommandSize * sizeof(char));
+
+    impl->history.buf = (char *) buf;
+    impl->history.bufferSize = config->historyBufferSize;
+
+    if (allocated)
+        SET_FLAG(impl->flags, CLI_FLAG_ALLOCATED);
+
+    if (config->enableAutoComplete)
+        SET_FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_ENABLED);
+
+    fifoBufInit(&impl->rxBuffer, config->rxBufferSize);
+    fifoBufInit(&impl->txBuffer, config->txBufferSize);
+    impl->txPolicy = config->txPolicy;
+    impl->xonXoff = config->xonXoff;
+    impl->rxHighWatermark = config->rxHighWatermark;
+    impl->rxLowWatermark = config->rxLowWatermark;
+    impl->rxThrottled = 0;
+    impl->rxOverflow = 0;
+    impl->txPaused = 0;
+    impl->txControlChar = 0;
+    impl->txControlPeeked = 0;
+    impl->outputDepth = 0;
+    impl->cmdMaxSize = config->cmdBufferSize;
+    impl->bindingsCount = 0;
+    impl->maxBindingsCount = (uint16_t) (config->maxBindingCount + cliInternalBindingCount);
+    impl->lastChar = '\0';
+    impl->pasting = false;
+    impl->inputState = INPUT_STATE_NORMAL;
+    impl->invitation = config->invitation;
+    impl->cursorPos = 0;
+    impl->dialect = config->dialect;
+    impl->logLevel = config->logLevel;
+    impl->logSourceCount = config->logSourceCount;
+    impl->logRateLimit = config->logRateLimit;
+    impl->logBurst = config->logBurst > 0 ? config->logBurst : 1;
+    impl->logTimestamps = config->logTimestamps;
+    for (uint8_t i = 0; i < impl->logSourceCount; ++i) {
+        impl->logSources[i].level = config->logLevel;
+        impl->logSources[i].tokens = impl->logBurst;
+    }
+    impl->printQueue.mask = printQueueSize > 0 ? (uint16_t) (printQueueSize - 1) : 0;
+    impl->printQueue.messageSize = config->printQueueMessageSize;
+    impl->printQueue.enqueuePos = 0;
+    impl->printQueue.dequeuePos = 0;
+    impl->filter.type = FILTER_NONE;
+    impl->capture.commandSize = config->captureCommandSize;
+    impl->capture.buf = NULL;
+    impl->printBatchDepth = 0;
+    impl->printCoalesceMs = config->printCoalesceMs;
+    impl->lastPrintMs = 0;
+    impl->terminalWidth = config->terminalWidth;
+    impl->terminalHeight = config->terminalHeight;
+    impl->pager.content = PAGER_NONE;
+    impl->generator = NULL;
+    impl->measuredTable = NULL;
+    impl->generatorBudgetMs = config->generatorBudgetMs;
+    impl->statusLineCount = config->statusLineCount;
+    impl->statusLinesScrolled = 0;
+    impl->statusLineLength = config->statusLineLength;
+    impl->progress = 0;
+    impl->scrollback.size = config->scrollbackSize;
+    impl->scrollback.head = 0;
+    impl->scrollback.length = 0;
+    impl->scrollback.lineStart = true;
+    impl->tailLines.size = config->tailBufferSize;
+    impl->tailLines.head = 0;
+    impl->tailLines.length = 0;
+    impl->tailLines.lineStart = true;
+    for (uint16_t i = 0; i < printQueueSize; ++i) {
+        impl->printQueue.sequences[i] = i;
+    }
+
+    initInternalBindings(cli);
+
+    return cli;
+}
+
+EmbeddedCli *embeddedCliNewDefault(void) {
+    return embeddedCliNew(embeddedCliDefaultConfig());
+}
+
+void embeddedCliReceiveChar(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
+
+    if (!fifoBufPush(&impl->rxBuffer, c)) {
+        CLI_ATOMIC_STORE(&impl->rxOverflow, 1);
+    }
+    onCharsReceived(cli, scanReceivedChars(cli, &c, 1));
+}
+
+uint16_t embeddedCliReceiveBuffer(EmbeddedCli *cli, const char *data, uint16_t len) {
+    PREPARE_IMPL(cli);
+
+    uint16_t pushed = fifoBufPushBuffer(&impl->rxBuffer, data, len);
+    if (pushed < len) {
+        CLI_ATOMIC_STORE(&impl->rxOverflow, 1);
+    }
+    if (len > 0)
+        onCharsReceived(cli, scanReceivedChars(cli, data, pushed));
+    return pushed;
+}
+
+void embeddedCliAttachRxBuffer(EmbeddedCli *cli, char *buf, uint16_t size) {
+    PREPARE_IMPL(cli);
+
+    fifoBufInit(&impl->rxBuffer, size);
+    impl->rxBuffer.buf = buf;
+}
+
+void embeddedCliSetRxWriteIndex(EmbeddedCli *cli, uint16_t index) {
+    PREPARE_IMPL(cli);
+
+    if (impl->rxBuffer.size == 0)
+        return;
+
+    // write index is position after last char, as back of fifo buffer
+    FifoBuf *buffer = &impl->rxBuffer;
+    uint16_t back = CLI_ATOMIC_LOAD_RELAXED(&buffer->back);
+    index = fifoBufWrap(buffer, index);
+    CLI_ATOMIC_STORE(&buffer->back, index);
+
+    if (index != back) {
+        bool lineComplete;
+        if (index > back) {
+            lineComplete = scanReceivedChars(cli, &buffer->buf[back], (uint16_t) (index - back));
+        } else {
+            lineComplete = scanReceivedChars(cli, &buffer->buf[back], (uint16_t) (buffer->size - back));
+            lineComplete = scanReceivedChars(cli, buffer->buf, index) || lineComplete;
+        }
+        onCharsReceived(cli, lineComplete);
+    }
+}
+
+uint8_t embeddedCliProcess(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    uint8_t status = CLI_STATUS_IDLE;
+    if (embeddedCliProcessBudget(cli, 0, 0, NULL))
+        status = CLI_STATUS_INPUT_PENDING;
+    if (fifoBufAvailable(&impl->txBuffer) > 0 || CLI_ATOMIC_LOAD_RELAXED(&impl->txControlChar) != 0)
+        status |= CLI_STATUS_OUTPUT_PENDING;
+
+    if (isPrintQueued(cli))
+        status |= CLI_STATUS_PRINT_PENDING;
+
+    uint32_t delayMs;
+    if (embeddedCliGetWakeDelay(cli, &delayMs))
+        status |= CLI_STATUS_TIMER_PENDING;
+    return status;
+}
+
+bool embeddedCliGetWakeDelay(EmbeddedCli *cli, uint32_t *delayMs) {
+    PREPARE_IMPL(cli);
+
+    // input line is printed back when time window after last print is
+    // elapsed, other processing doesn't depend on time
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN) || impl->printBatchDepth > 0 ||
+        !isCoalesceWindowEnabled(cli))
+        return false;
+
+    uint32_t elapsed = cli->getTimeMs(cli) - impl->lastPrintMs;
+    *delayMs = elapsed < impl->printCoalesceMs ? impl->printCoalesceMs - elapsed : 0;
+    return true;
+}
+
+bool embeddedCliProcessBudget(EmbeddedCli *cli, uint16_t maxChars, uint32_t maxMicros,
+                              EmbeddedCliClock clock) {
+    if (!isOutputAvailable(cli))
+        return false;
+
+    PREPARE_IMPL(cli);
+
+    ProcessBudget budget;
+    budget.maxChars = maxChars;
+    budget.chars = 0;
+    budget.maxMicros = clock != NULL ? maxMicros : 0;
+    budget.startMicros = budget.maxMicros > 0 ? clock(cli) : 0;
+    budget.clock = clock;
+    char c;
+
+    // pending flow control char is sent before processing (which can take
+    // long), so sender is stopped as soon as possible
+    if (CLI_ATOMIC_LOAD_RELAXED(&impl->txControlChar) != 0)
+        flushOutput(cli);
+
+    embeddedCliBeginOutput(cli);
+
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_INIT_COMPLETE)) {
+        SET_FLAG(impl->flags, CLI_FLAG_INIT_COMPLETE);
+        writeToOutput(cli, impl->invitation);
+        setupStatusArea(cli);
+    }
+
+    processPrintQueue(cli);
+
+    // print current command back when coalesced prints are finished or when
+    // user continues typing
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN)) {
+        bool windowElapsed = !isCoalesceWindowEnabled(cli) ||
+                             cli->getTimeMs(cli) - impl->lastPrintMs >= impl->printCoalesceMs;
+        if (fifoBufAvailable(&impl->rxBuffer) > 0 || (impl->printBatchDepth == 0 && windowElapsed))
+            restoreInputLine(cli);
+    }
+
+    // until paused listing is continued, input is used only by pager
+    while (impl->pager.waiting && takeInputChar(cli, &budget, &c)) {
+        onPagerInput(cli, c);
+        impl->lastChar = c;
+    }
+
+    // generator is called at most once per process call, so time budget is
+    // not exceeded
+    bool generatorCalled = impl->generator != NULL;
+    runGenerator(cli);
+
+    // input is kept in rx buffer while generator is active
+    while (impl->generator == NULL && takeInputChar(cli, &budget, &c)) {
+        if (impl->pasting && c == '\t')
+            c = ' ';
+
+        if (impl->inputState != INPUT_STATE_NORMAL && onEscapedInput(cli, c)) {
+            // char is part of escape sequence
+        } else if (isDisplayableChar(c)) {
+            if (impl->cursorPos == 0 && fifoBufAvailable(&impl->rxBuffer) > 0)
+                c = onCharRunInput(cli, &budget, c);
+            else
+                onCharInput(cli, c);
+        } else {
+            onControlInput(cli, c);
+        }
+
+        // while input is backlogged, autocompletion is computed only once
+        // after the last char
+        if (!impl->pasting && fifoBufAvailable(&impl->rxBuffer) == 0)
+            printLiveAutocompletion(cli);
+
+        impl->lastChar = c;
+    }
+
+    // discard unfinished command if overflow happened (dropped chars follow
+    // chars that are still in rx buffer)
+    bool inputAvailable = fifoBufAvailable(&impl->rxBuffer) > 0;
+    if (CLI_ATOMIC_LOAD(&impl->rxOverflow) != 0 && (!inputAvailable || impl->generator != NULL)) {
+        CLI_ATOMIC_STORE(&impl->rxOverflow, 0);
+        impl->cmdSize = 0;
+        impl->cmdBuffer[impl->cmdSize] = '\0';
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+    }
+
+    // sender can continue when most of received chars are processed
+    if (CLI_ATOMIC_LOAD_RELAXED(&impl->rxThrottled) != 0) {
+        uint16_t lowWatermark = impl->rxLowWatermark > 0 ? impl->rxLowWatermark :
+                                (uint16_t) (impl->rxBuffer.size / 4);
+        if (fifoBufAvailable(&impl->rxBuffer) <= lowWatermark)
+            setRxThrottled(cli, false);
+    }
+
+    // generator could be started by command
+    if (!generatorCalled)
+        runGenerator(cli);
+
+    embeddedCliEndOutput(cli);
+
+    // input is kept while generator is active, but generator itself is work
+    return inputAvailable || (impl->generator != NULL && !impl->pager.waiting);
+}
+
+void embeddedCliBeginOutput(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    ++impl->outputDepth;
+}
+
+bool embeddedCliEndOutput(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    bool overflow = IS_FLAG_SET(impl->flags, CLI_FLAG_TX_OVERFLOW);
+    if (impl->outputDepth == 0)
+        return !overflow;
+
+    --impl->outputDepth;
+    if (impl->outputDepth == 0) {
+        flushOutput(cli);
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_TX_OVERFLOW);
+    }
+    return !overflow;
+}
+
+bool embeddedCliTxPeek(EmbeddedCli *cli, const char **data, uint16_t *len) {
+    PREPARE_IMPL(cli);
+    // flow control char is sent first, even while output is paused
+    uint16_t controlChar = CLI_ATOMIC_LOAD(&impl->txControlChar);
+    if (controlChar != 0) {
+        impl->txControlPeeked = (char) controlChar;
+        *data = &impl->txControlPeeked;
+        *len = 1;
+        return true;
+    }
+
+    if (impl->txBuffer.size == 0 || CLI_ATOMIC_LOAD(&impl->txPaused) != 0) {
+        *len = 0;
+        return false;
+    }
+
+    *len = fifoBufPeek(&impl->txBuffer, data);
+    return *len > 0;
+}
+
+void embeddedCliTxConsume(EmbeddedCli *cli, uint16_t count) {
+    PREPARE_IMPL(cli);
+    if (count == 0)
+        return;
+
+    if (impl->txControlPeeked != 0) {
+        // char is cleared only if it wasn't replaced after peek
+        uint16_t peeked = (uint8_t) impl->txControlPeeked;
+        uint16_t expected = peeked;
+        while (!CLI_ATOMIC_CAS(&impl->txControlChar, &expected, 0) && expected == peeked) {
+        }
+        impl->txControlPeeked = 0;
+        --count;
+    }
+
+    if (impl->txBuffer.size == 0 || count == 0)
+        return;
+
+    fifoBufConsume(&impl->txBuffer, count);
+}
+
+bool embeddedCliAddBinding(EmbeddedCli *cli, CliCommandBinding binding) {
+    PREPARE_IMPL(cli);
+    if (impl->bindingsCount == impl->maxBindingsCount)
+        return false;
+
+    impl->bindings[impl->bindingsCount] = binding;
+
+    ++impl->bindingsCount;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+    return true;
+}
+
+bool embeddedCliCapture(EmbeddedCli *cli, const char *command,
+                        char *buf, uint16_t capacity, uint16_t *length) {
+    PREPARE_IMPL(cli);
+    Capture *capture = &impl->capture;
+
+    *length = 0;
+    size_t commandLen = strlen(command);
+    // command is followed by two zeros (as in cmd buffer)
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING) || commandLen + 2 > capture->commandSize)
+        return false;
+
+    memcpy(capture->command, command, commandLen + 1);
+    capture->buf = buf;
+    capture->capacity = capacity;
+    capture->length = 0;
+    capture->truncated = false;
+
+    // capture can be called from binding, so state of its command is restored
+    uint16_t directPrint = impl->flags & CLI_FLAG_DIRECT_PRINT;
+    OutputFilter filter = impl->filter;
+    EmbeddedCliGenerator generator = impl->generator;
+    void *generatorContext = impl->generatorContext;
+    impl->filter.type = FILTER_NONE;
+    impl->generator = NULL;
+
+    SET_FLAG(impl->flags, CLI_FLAG_CAPTURING);
+    executeCommand(cli, capture->command, (uint16_t) commandLen);
+    SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    // generator is called until it is finished, there is no time budget
+    while (impl->generator != NULL) {
+        if (!impl->generator(cli, impl->generatorContext))
+            impl->generator = NULL;
+    }
+    finishFilter(cli);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_CAPTURING);
+
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    impl->flags |= directPrint;
+    impl->filter = filter;
+    impl->generator = generator;
+    impl->generatorContext = generatorContext;
+
+    capture->buf = NULL;
+    *length = capture->length;
+    return !capture->truncated;
+}
+
+void embeddedCliPrint(EmbeddedCli *cli, const char *string) {
+    if (!isOutputAvailable(cli))
+        return;
+
+    if (beginLineMatch(cli)) {
+        writeToOutput(cli, string);
+        endLineMatch(cli);
+    }
+
+    beginPrint(cli);
+    writeToOutput(cli, string);
+    endPrint(cli);
+}
+
+void embeddedCliPrintf(EmbeddedCli *cli, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    embeddedCliVPrintf(cli, format, args);
+    va_end(args);
+}
+
+void embeddedCliVPrintf(EmbeddedCli *cli, const char *format, va_list args) {
+    if (!isOutputAvailable(cli))
+        return;
+
+    if (beginLineMatch(cli)) {
+        // arguments are formatted twice: for matching and for printing
+        va_list matchArgs;
+        va_copy(matchArgs, args);
+        formatToOutput(cli, format, matchArgs);
+        va_end(matchArgs);
+        endLineMatch(cli);
+    }
+
+    beginPrint(cli);
+    formatToOutput(cli, format, args);
+    endPrint(cli);
+}
+
+void embeddedCliTableHeader(EmbeddedCli *cli, EmbeddedCliTable *table) {
+    if (!isOutputAvailable(cli))
+        return;
+
+    beginPrint(cli);
+    for (uint8_t i = 0; i < table->columnCount; ++i) {
+        EmbeddedCliTableColumn *column = &table->columns[i];
+        const char *title = column->title != NULL ? column->title : "";
+        size_t len = strlen(title);
+        size_t padding = column->width > len ? column->width - len : 0;
+
+        if (i > 0)
+            writeToOutput(cli, tableSeparator);
+        if (column->align == CLI_ALIGN_RIGHT)
+            writePadding(cli, ' ', padding);
+        writeCharsToOutput(cli, title, len);
+        if (column->align == CLI_ALIGN_LEFT && i + 1 < table->columnCount)
+            writePadding(cli, ' ', padding);
+    }
+    endPrint(cli);
+
+    beginPrint(cli);
+    for (uint8_t i = 0; i < table->columnCount; ++i) {
+        if (i > 0)
+            writeToOutput(cli, tableSeparator);
+        writePadding(cli, '-', table->columns[i].width);
+    }
+    endPrint(cli);
+}
+
+void embeddedCliTableRow(EmbeddedCli *cli, EmbeddedCliTable *table, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    embeddedCliVTableRow(cli, table, format, args);
+    va_end(args);
+}
+
+void embeddedCliVTableRow(EmbeddedCli *cli, EmbeddedCliTable *table, const char *format, va_list args) {
+    PREPARE_IMPL(cli);
+
+    if (impl->measuredTable == table) {
+        formatCells(cli, format, args, table, true);
+        return;
+    }
+    if (!isOutputAvailable(cli))
+        return;
+
+    if (beginLineMatch(cli)) {
+        va_list matchArgs;
+        va_copy(matchArgs, args);
+        formatCells(cli, format, matchArgs, table, false);
+        va_end(matchArgs);
+        endLineMatch(cli);
+    }
+
+    beginPrint(cli);
+    formatCells(cli, format, args, table, false);
+    endPrint(cli);
+}
+
+void embeddedCliPrintTable(EmbeddedCli *cli, EmbeddedCliTable *table,
+                           EmbeddedCliTableRowGenerator generator, void *context) {
+    PREPARE_IMPL(cli);
+
+    if (!isOutputAvailable(cli))
+        return;
+
+    // first pass: columns are made wide enough for titles and all cells
+    for (uint8_t i = 0; i < table->columnCount; ++i) {
+        EmbeddedCliTableColumn *column = &table->columns[i];
+        size_t len = column->title != NULL ? strlen(column->title) : 0;
+        column->width = (uint8_t) (len < UINT8_MAX ? len : UINT8_MAX);
+    }
+    impl->measuredTable = table;
+    for (uint16_t row = 0; generator(cli, table, row, context); ++row);
+    impl->measuredTable = NULL;
+
+    // second pass: rows are printed, input line is redrawn only once
+    embeddedCliBeginPrintBatch(cli);
+    embeddedCliTableHeader(cli, table);
+    for (uint16_t row = 0; generator(cli, table, row, context); ++row);
+    embeddedCliEndPrintBatch(cli);
+}
+
+void embeddedCliReplayScrollback(EmbeddedCli *cli, uint16_t bytes) {
+    PREPARE_IMPL(cli);
+    printScrollback(cli, &impl->scrollback, bytes, 0);
+}
+
+void embeddedCliBeginPrintBatch(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    ++impl->printBatchDepth;
+}
+
+void embeddedCliEndPrintBatch(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    if (impl->printBatchDepth == 0)
+        return;
+
+    --impl->printBatchDepth;
+    if (impl->printBatchDepth == 0 && !isCoalesceWindowEnabled(cli) &&
+        IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN)) {
+        embeddedCliBeginOutput(cli);
+        restoreInputLine(cli);
+        embeddedCliEndOutput(cli);
+    }
+}
+
+bool embeddedCliPostPrint(EmbeddedCli *cli, const char *string) {
+    PREPARE_IMPL(cli);
+    PrintQueue *queue = &impl->printQueue;
+
+    if (queue->messages == NULL)
+        return false;
+
+    // reserve slot for message
+    uint16_t pos = CLI_ATOMIC_LOAD_RELAXED(&queue->enqueuePos);
+    uint16_t index;
+    for (;;) {
+        index = (uint16_t) (pos & queue->mask);
+        uint16_t sequence = CLI_ATOMIC_LOAD(&queue->sequences[index]);
+        int16_t diff = (int16_t) (uint16_t) (sequence - pos);
+        if (diff == 0) {
+            // slot is free, try to take it (pos is updated on failure)
+            if (CLI_ATOMIC_CAS(&queue->enqueuePos, &pos, (uint16_t) (pos + 1)))
+                break;
+        } else if (diff < 0) {
+            // slot still contains message from previous round, queue is full
+            return false;
+        } else {
+            // slot was taken by another producer
+            pos = CLI_ATOMIC_LOAD_RELAXED(&queue->enqueuePos);
+        }
+    }
+
+    char *message = &queue->messages[index * queue->messageSize];
+    uint16_t len = 0;
+    while (string[len] != '\0' && len + 1 < queue->messageSize) {
+        message[len] = string[len];
+        ++len;
+    }
+    message[len] = '\0';
+
+    // publish message to consumer
+    CLI_ATOMIC_STORE(&queue->sequences[index], (uint16_t) (pos + 1));
+
+    if (cli->onPrintPosted != NULL)
+        cli->onPrintPosted(cli);
+    return true;
+}
+
+void embeddedCliLog(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source, const char *format, ...) {
+    // reject message before arguments are touched
+    if (!embeddedCliIsLogEnabled(cli, level, source))
+        return;
+
+    va_list args;
+    va_start(args, format);
+    embeddedCliVLog(cli, level, source, format, args);
+    va_end(args);
+}
+
+void embeddedCliVLog(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source,
+                     const char *format, va_list args) {
+    if (!isOutputAvailable(cli) || !embeddedCliIsLogEnabled(cli, level, source))
+        return;
+
+    PREPARE_IMPL(cli);
+
+    LogSource *logSource = source < impl->logSourceCount ? &impl->logSources[source] : NULL;
+    uint16_t droppedCount = 0;
+    if (logSource != NULL) {
+        if (!takeLogToken(cli, logSource)) {
+            if (logSource->droppedCount < UINT16_MAX)
+                ++logSource->droppedCount;
+            return;
+        }
+        droppedCount = logSource->droppedCount;
+        logSource->droppedCount = 0;
+    }
+
+    if (beginLineMatch(cli)) {
+        va_list matchArgs;
+        va_copy(matchArgs, args);
+        writeLogPrefix(cli, level, logSource);
+        formatToOutput(cli, format, matchArgs);
+        va_end(matchArgs);
+        endLineMatch(cli);
+    }
+
+    beginPrint(cli);
+    if (droppedCount > 0) {
+        writeLogPrefix(cli, CLI_LOG_WARNING, logSource);
+        writeFormatted(cli, "%u messages dropped", (unsigned int) droppedCount);
+        writeToOutput(cli, lineBreak);
+    }
+    writeLogPrefix(cli, level, logSource);
+    formatToOutput(cli, format, args);
+    endPrint(cli);
+}
+
+bool embeddedCliIsLogEnabled(EmbeddedCli *cli, EmbeddedCliLogLevel level, uint8_t source) {
+    PREPARE_IMPL(cli);
+
+    if (level == CLI_LOG_NONE)
+        return false;
+
+    EmbeddedCliLogLevel sourceLevel = source < impl->logSourceCount ?
+                                      impl->logSources[source].level : impl->logLevel;
+    return level <= sourceLevel;
+}
+
+void embeddedCliSetLogLevel(EmbeddedCli *cli, uint8_t source, EmbeddedCliLogLevel level) {
+    PREPARE_IMPL(cli);
+
+    if (source == CLI_LOG_SOURCE_ALL) {
+        impl->logLevel = level;
+        for (uint8_t i = 0; i < impl->logSourceCount; ++i) {
+            impl->logSources[i].level = level;
+        }
+    } else if (source < impl->logSourceCount) {
+        impl->logSources[source].level = level;
+    }
+}
+
+void embeddedCliSetLogSourceName(EmbeddedCli *cli, uint8_t source, const char *name) {
+    PREPARE_IMPL(cli);
+
+    if (source < impl->logSourceCount)
+        impl->logSources[source].name = name;
+}
+
+bool embeddedCliAddLogLevelBinding(EmbeddedCli *cli) {
+    CliCommandBinding b = {
+            "log-level",
+            "Show or change log levels. Usage: log-level [source] [none|error|warning|info|debug]",
+            true,
+            NULL,
+            onLogLevel
+    };
+    return embeddedCliAddBinding(cli, b);
+}
+
+bool embeddedCliSetStatusLine(EmbeddedCli *cli, uint8_t index, const char *text) {
+    PREPARE_IMPL(cli);
+
+    if (index >= impl->statusLineCount)
+        return false;
+
+    char *line = &impl->statusLines[index * (impl->statusLineLength + 1)];
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_STATUS_AREA) && isOutputAvailable(cli)) {
+        // status line is drawn on screen even when output is captured
+        uint16_t capturing = impl->flags & CLI_FLAG_CAPTURING;
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_CAPTURING);
+        embeddedCliBeginOutput(cli);
+        drawStatusLine(cli, index, text, false);
+        embeddedCliEndOutput(cli);
+        impl->flags |= capturing;
+    }
+
+    size_t len = strlen(text);
+    if (len > impl->statusLineLength)
+        len = impl->statusLineLength;
+    memcpy(line, text, len);
+    line[len] = '\0';
+    return true;
+}
+
+bool embeddedCliShowProgress(EmbeddedCli *cli, uint8_t percent) {
+    PREPARE_IMPL(cli);
+
+    // progress can be shown only when input line is not displayed
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT) && impl->generator == NULL)
+        return false;
+    // captured output has no current line
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING))
+        return false;
+    if (!isOutputAvailable(cli))
+        return false;
+
+    if (percent > 100)
+        percent = 100;
+
+    char progress[CLI_PROGRESS_LENGTH];
+    formatProgress(progress, percent);
+
+    embeddedCliBeginOutput(cli);
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_PROGRESS_SHOWN)) {
+        writeCharsToOutput(cli, progress, CLI_PROGRESS_LENGTH);
+        SET_FLAG(impl->flags, CLI_FLAG_PROGRESS_SHOWN);
+    } else {
+        // only changed cells are written, cursor stays at the end of indicator
+        char previous[CLI_PROGRESS_LENGTH];
+        formatProgress(previous, impl->progress);
+        uint16_t first = 0;
+        while (first < CLI_PROGRESS_LENGTH && previous[first] == progress[first])
+            ++first;
+        if (first < CLI_PROGRESS_LENGTH) {
+            uint16_t last = CLI_PROGRESS_LENGTH - 1;
+            // without escape sequences cursor can't be moved forward
+            while (isEscSeqSupported(cli) && previous[last] == progress[last])
+                --last;
+            moveCursor(cli, (uint16_t) (CLI_PROGRESS_LENGTH - first), CURSOR_DIRECTION_BACKWARD);
+            writeCharsToOutput(cli, &progress[first], (size_t) (last - first + 1));
+            moveCursor(cli, (uint16_t) (CLI_PROGRESS_LENGTH - 1 - last), CURSOR_DIRECTION_FORWARD);
+        }
+    }
+    impl->progress = percent;
+    embeddedCliEndOutput(cli);
+    return true;
+}
+
+void embeddedCliHideProgress(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_PROGRESS_SHOWN))
+        return;
+
+    embeddedCliBeginOutput(cli);
+    clearProgress(cli);
+    embeddedCliEndOutput(cli);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_PROGRESS_SHOWN);
+}
+
+bool embeddedCliStartGenerator(EmbeddedCli *cli, EmbeddedCliGenerator generator, void *context) {
+    PREPARE_IMPL(cli);
+
+    if (impl->generator != NULL)
+        return false;
+
+    impl->generator = generator;
+    impl->generatorContext = context;
+    impl->generatorMaxChunk = 0;
+    return true;
+}
+
+void embeddedCliSetTerminalSize(EmbeddedCli *cli, uint16_t width, uint16_t height) {
+    PREPARE_IMPL(cli);
+    impl->terminalWidth = width;
+    impl->terminalHeight = height;
+
+    embeddedCliBeginOutput(cli);
+    setupStatusArea(cli);
+    embeddedCliEndOutput(cli);
+}
+
+void embeddedCliRequestTerminalSize(EmbeddedCli *cli) {
+    if (!isOutputAvailable(cli) || !isEscSeqSupported(cli))
+        return;
+
+    embeddedCliBeginOutput(cli);
+    writeToOutput(cli, escSeqCursorSave);
+    writeToOutput(cli, escSeqRequestSize);
+    writeToOutput(cli, escSeqCursorRestore);
+    embeddedCliEndOutput(cli);
+}
+
+void embeddedCliSetDialect(EmbeddedCli *cli, EmbeddedCliDialect dialect) {
+    PREPARE_IMPL(cli);
+    impl->dialect = dialect;
+}
+
+void embeddedCliFree(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_ALLOCATED)) {
+        // allocation is done in single call to malloc, so need only single free
+        free(cli);
+    }
+}
+
+void embeddedCliTokenizeArgs(char *args) {
+    if (args == NULL)
+        return;
+
+    // for now only space, but can add more later
+    const char *separators = " ";
+
+    // indicates that arg is quoted so separators are copied as is
+    bool quotesEnabled = false;
+    // indicates that previous char was a slash, so next char is copied as is
+    bool escapeActivated = false;
+    int insertPos = 0;
+
+    int i = 0;
+    char currentChar;
+    while ((currentChar = args[i]) != '\0') {
+        ++i;
+
+        if (escapeActivated) {
+            escapeActivated = false;
+        } else if (currentChar == '\\') {
+            escapeActivated = true;
+            continue;
+        } else if (currentChar == '"') {
+            quotesEnabled = !quotesEnabled;
+            currentChar = '\0';
+        } else if (!quotesEnabled && strchr(separators, currentChar) != NULL) {
+            currentChar = '\0';
+        }
+
+        // null chars are only copied once and not copied to the beginning
+        if (currentChar != '\0' || (insertPos > 0 && args[insertPos - 1] != '\0')) {
+            args[insertPos] = currentChar;
+            ++insertPos;
+        }
+    }
+
+    // make args double null-terminated source buffer must be big enough to contain extra spaces
+    args[insertPos] = '\0';
+    args[insertPos + 1] = '\0';
+}
+
+const char *embeddedCliGetToken(const char *tokenizedStr, uint16_t pos) {
+    uint16_t i = getTokenPosition(tokenizedStr, pos);
+
+    if (i != CLI_TOKEN_NPOS)
+        return &tokenizedStr[i];
+    else
+        return NULL;
+}
+
+char *embeddedCliGetTokenVariable(char *tokenizedStr, uint16_t pos) {
+    uint16_t i = getTokenPosition(tokenizedStr, pos);
+
+    if (i != CLI_TOKEN_NPOS)
+        return &tokenizedStr[i];
+    else
+        return NULL;
+}
+
+uint16_t embeddedCliFindToken(const char *tokenizedStr, const char *token) {
+    if (tokenizedStr == NULL || token == NULL)
+        return 0;
+
+    uint16_t size = embeddedCliGetTokenCount(tokenizedStr);
+    for (uint16_t i = 1; i <= size; ++i) {
+        if (strcmp(embeddedCliGetToken(tokenizedStr, i), token) == 0)
+            return i;
+    }
+
+    return 0;
+}
+
+uint16_t embeddedCliGetTokenCount(const char *tokenizedStr) {
+    if (tokenizedStr == NULL || tokenizedStr[0] == '\0')
+        return 0;
+
+    int i = 0;
+    uint16_t tokenCount = 1;
+    while (true) {
+        if (tokenizedStr[i] == '\0') {
+            if (tokenizedStr[i + 1] == '\0')
+                break;
+            ++tokenCount;
+        }
+        ++i;
+    }
+
+    return tokenCount;
+}
+
+static void navigateHistory(EmbeddedCli *cli, bool navigateUp) {
+    PREPARE_IMPL(cli);
+    if (impl->history.itemsCount == 0 ||
+        (navigateUp && impl->history.current == impl->history.itemsCount) ||
+        (!navigateUp && impl->history.current == 0))
+        return;
+
+    if (navigateUp)
+        ++impl->history.current;
+    else
+        --impl->history.current;
 
-/**
- * Show error about unknown command
- * @param cli
- * @param name
- */
-static void onUnknownCommand(EmbeddedCli *cli, const char *name);
+    const char *item = historyGet(&impl->history, impl->history.current);
+    // simple way to handle empty command the same way as others
+    if (item == NULL)
+        item = "";
+    replaceCommand(cli, item);
 
-/**
- * Return autocompleted command for given prefix.
- * Prefix is compared to all known command bindings and autocompleted result
- * is returned
- * @param cli
- * @param prefix
- * @return
- */
-static AutocompletedCommand getAutocompletedCommand(EmbeddedCli *cli, const char *prefix);
+    printLiveAutocompletion(cli);
+}
 
-/**
- * Prints autocompletion result while keeping current command unchanged
- * Prints only if autocompletion is present and only one candidate exists.
- * @param cli
- */
-static void printLiveAutocompletion(EmbeddedCli *cli);
+static bool onEscapedInput(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
 
-/**
- * Handles autocomplete request. If autocomplete possible - fills current
- * command with autocompleted command. When multiple commands satisfy entered
- * prefix, they are printed to output.
- * @param cli
- */
-static void onAutocompleteRequest(EmbeddedCli *cli);
+    if (impl->inputState == INPUT_STATE_ESCAPE) {
+        impl->inputState = INPUT_STATE_NORMAL;
+        if (c == '[' || c == 'O') {
+            impl->inputState = c == '[' ? INPUT_STATE_CSI : INPUT_STATE_SS3;
+            impl->escParams[0] = 0;
+            impl->escParams[1] = 0;
+            impl->escParamIndex = 0;
+        } else if (c == 'b' || c == 'f') {
+            // Alt+B and Alt+F
+            onKeyInput(cli, c == 'b' ? INPUT_KEY_WORD_LEFT : INPUT_KEY_WORD_RIGHT);
+        } else if (c == 0x1B) {
+            impl->inputState = INPUT_STATE_ESCAPE;
+        } else {
+            return false;
+        }
+        return true;
+    }
 
-/**
- * Removes all input from current line (replaces it with whitespaces)
- * And places cursor at the beginning of the line
- * @param cli
- */
-static void clearCurrentLine(EmbeddedCli *cli);
+    if (impl->inputState == INPUT_STATE_SS3) {
+        impl->inputState = INPUT_STATE_NORMAL;
+        onKeyInput(cli, getSequenceKey(cli, c));
+        return true;
+    }
 
-/**
- * Write given string to cli output
- * @param cli
- * @param str
- */
-static void writeToOutput(EmbeddedCli *cli, const char *str);
+    if (c >= '0' && c <= '9') {
+        uint16_t *param = &impl->escParams[impl->escParamIndex];
+        if (*param < 1000)
+            *param = (uint16_t) (*param * 10 + (uint16_t) (c - '0'));
+    } else if (c == ';' && impl->escParamIndex == 0) {
+        impl->escParamIndex = 1;
+    } else if (c >= 64 && c <= 126) {
+        // final char, other chars (private and intermediate) are ignored
+        impl->inputState = INPUT_STATE_NORMAL;
+
+        if (c == 'R' && impl->escParamIndex == 1) {
+            // cursor position report (response to size request)
+            impl->terminalHeight = impl->escParams[0];
+            impl->terminalWidth = impl->escParams[1];
+            setupStatusArea(cli);
+        } else if (c == '~' && (impl->escParams[0] == 200 || impl->escParams[0] == 201)) {
+            // bracketed paste start or end
+            impl->pasting = impl->escParams[0] == 200;
+        } else {
+            onKeyInput(cli, getSequenceKey(cli, c));
+        }
+    }
+    return true;
+}
 
-/**
- * Move cursor forward (right) by given number of positions
- * @param cli
- * @param count
- * @param direction: true = forward (right), false = backward (left)
- */
-static void moveCursor(EmbeddedCli* cli, uint16_t count, bool direction);
+static InputKey getSequenceKey(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
 
-/**
- * Returns true if provided char is a supported control char:
- * \r, \n, \b or 0x7F (treated as \b)
- * @param c
- * @return
- */
-static bool isControlChar(char c);
+    // modifier is sent as 1 + bitmask (1 - Shift, 2 - Alt, 4 - Ctrl), arrows
+    // with Alt or Ctrl move by words
+    uint16_t modifier = impl->escParamIndex == 1 ? impl->escParams[1] : 0;
+    bool wordMove = modifier > 1 && ((modifier - 1) & 0x6) != 0;
+
+    switch (c) {
+        case 'A':
+            return INPUT_KEY_UP;
+        case 'B':
+            return INPUT_KEY_DOWN;
+        case 'C':
+            return wordMove ? INPUT_KEY_WORD_RIGHT : INPUT_KEY_RIGHT;
+        case 'D':
+            return wordMove ? INPUT_KEY_WORD_LEFT : INPUT_KEY_LEFT;
+        case 'H':
+            return INPUT_KEY_HOME;
+        case 'F':
+            return INPUT_KEY_END;
+        case '~':
+            // \e[1~ and \e[7~ are Home, \e[4~ and \e[8~ are End in different
+            // terminals
+            if (impl->escParams[0] == 1 || impl->escParams[0] == 7)
+                return INPUT_KEY_HOME;
+            if (impl->escParams[0] == 4 || impl->escParams[0] == 8)
+                return INPUT_KEY_END;
+            if (impl->escParams[0] == 3)
+                return INPUT_KEY_DELETE;
+            return INPUT_KEY_NONE;
+        default:
+            return INPUT_KEY_NONE;
+    }
+}
 
-/**
- * Returns true if provided char is a valid displayable character:
- * a-z, A-Z, 0-9, whitespace, punctuation, etc.
- * Currently only ASCII is supported
- * @param c
- * @return
- */
-static bool isDisplayableChar(char c);
+static void onKeyInput(EmbeddedCli *cli, InputKey key) {
+    PREPARE_IMPL(cli);
 
-/**
- * How many elements are currently available in buffer
- * @param buffer
- * @return number of elements
- */
-static uint16_t fifoBufAvailable(FifoBuf *buffer);
+    uint16_t count;
 
-/**
- * Return first character from buffer and remove it from buffer
- * Buffer must be non-empty, otherwise 0 is returned
- * @param buffer
- * @return
- */
-static char fifoBufPop(FifoBuf *buffer);
+    switch (key) {
+        case INPUT_KEY_ENTER:
+            submitCommand(cli);
+            break;
+        case INPUT_KEY_BACKSPACE:
+            if (impl->cmdSize - impl->cursorPos > 0) {
+                setCursorPos(cli, (uint16_t) (impl->cursorPos + 1));
+                removeChars(cli, 1);
+            }
+            break;
+        case INPUT_KEY_TAB:
+            onAutocompleteRequest(cli, true);
+            break;
+        case INPUT_KEY_UP:
+        case INPUT_KEY_DOWN:
+            navigateHistory(cli, key == INPUT_KEY_UP);
+            break;
+        case INPUT_KEY_RIGHT:
+            if (impl->cursorPos > 0)
+                setCursorPos(cli, (uint16_t) (impl->cursorPos - 1));
+            break;
+        case INPUT_KEY_LEFT:
+            if (impl->cursorPos < impl->cmdSize)
+                setCursorPos(cli, (uint16_t) (impl->cursorPos + 1));
+            break;
+        case INPUT_KEY_HOME:
+            setCursorPos(cli, impl->cmdSize);
+            break;
+        case INPUT_KEY_END:
+            setCursorPos(cli, 0);
+            break;
+        case INPUT_KEY_DELETE:
+            if (impl->cursorPos > 0)
+                removeChars(cli, 1);
+            break;
+        case INPUT_KEY_WORD_RIGHT:
+        case INPUT_KEY_WORD_LEFT:
+            setCursorPos(cli, getWordBoundary(cli, key == INPUT_KEY_WORD_RIGHT));
+            break;
+        case INPUT_KEY_KILL_LINE_END:
+            removeChars(cli, impl->cursorPos);
+            break;
+        case INPUT_KEY_KILL_LINE_START:
+            count = (uint16_t) (impl->cmdSize - impl->cursorPos);
+            setCursorPos(cli, impl->cmdSize);
+            removeChars(cli, count);
+            break;
+        case INPUT_KEY_KILL_WORD:
+            count = (uint16_t) (getWordBoundary(cli, false) - impl->cursorPos);
+            setCursorPos(cli, (uint16_t) (impl->cursorPos + count));
+            removeChars(cli, count);
+            break;
+        default:
+            break;
+    }
+}
 
-/**
- * Push character into fifo buffer. If there is no space left, character is
- * discarded and false is returned
- * @param buffer
- * @param a - character to add
- * @return true if char was added to buffer, false otherwise
- */
-static bool fifoBufPush(FifoBuf *buffer, char a);
+static void setCursorPos(EmbeddedCli *cli, uint16_t cursorPos) {
+    PREPARE_IMPL(cli);
 
-/**
- * Copy provided string to the history buffer.
- * If it is already inside history, it will be removed from it and added again.
- * So after addition, it will always be on top
- * If available size is not enough (and total size is enough) old elements will
- * be removed from history so this item can be put to it
- * @param history
- * @param str
- * @return true if string was put in history
- */
-static bool historyPut(CliHistory *history, const char *str);
+    if (cursorPos > impl->cursorPos) {
+        moveCursor(cli, (uint16_t) (cursorPos - impl->cursorPos), CURSOR_DIRECTION_BACKWARD);
+    } else if (cursorPos < impl->cursorPos) {
+        uint16_t count = (uint16_t) (impl->cursorPos - cursorPos);
+        if (!isEscSeqSupported(cli) || (isPartialRedrawSupported(cli) && count < 4)) {
+            // printing chars under cursor moves it right with single char each
+            writeCharsToOutput(cli, &impl->cmdBuffer[impl->cmdSize - impl->cursorPos], count);
+        } else {
+            moveCursor(cli, count, CURSOR_DIRECTION_FORWARD);
+        }
+    }
+    impl->cursorPos = cursorPos;
+}
 
-/**
- * Get item from history. Items are counted from 1 so if item is 0 or greater
- * than itemCount, NULL is returned
- * @param history
- * @param item
- * @return true if string was put in history
- */
-static const char *historyGet(CliHistory *history, uint16_t item);
+static uint16_t getWordBoundary(EmbeddedCli *cli, bool forward) {
+    PREPARE_IMPL(cli);
 
-/**
- * Remove specific item from history
- * @param history
- * @param str - string to remove
- * @return
- */
-static void historyRemove(CliHistory *history, const char *str);
+    uint16_t pos = (uint16_t) (impl->cmdSize - impl->cursorPos);
+    if (forward) {
+        while (pos < impl->cmdSize && impl->cmdBuffer[pos] == ' ')
+            ++pos;
+        while (pos < impl->cmdSize && impl->cmdBuffer[pos] != ' ')
+            ++pos;
+    } else {
+        while (pos > 0 && impl->cmdBuffer[pos - 1] == ' ')
+            --pos;
+        while (pos > 0 && impl->cmdBuffer[pos - 1] != ' ')
+            --pos;
+    }
+    return (uint16_t) (impl->cmdSize - pos);
+}
 
-/**
- * Return position (index of first char) of specified token
- * @param tokenizedStr - tokenized string (separated by \0 with
- * \0\0 at the end)
- * @param pos - token position (counted from 1)
- * @return index of first char of specified token
- */
-static uint16_t getTokenPosition(const char *tokenizedStr, uint16_t pos);
+static void removeChars(EmbeddedCli *cli, uint16_t count) {
+    PREPARE_IMPL(cli);
 
-EmbeddedCliConfig *embeddedCliDefaultConfig(void) {
-    defaultConfig.rxBufferSize = 64;
-    defaultConfig.cmdBufferSize = 64;
-    defaultConfig.historyBufferSize = 128;
-    defaultConfig.cliBuffer = NULL;
-    defaultConfig.cliBufferSize = 0;
-    defaultConfig.maxBindingCount = 8;
-    defaultConfig.enableAutoComplete = true;
-    defaultConfig.invitation = "> ";
-    return &defaultConfig;
+    if (count == 0)
+        return;
+
+    size_t pos = impl->cmdSize - impl->cursorPos;
+    uint16_t tailLen = (uint16_t) (impl->cursorPos - count);
+    if (isEscSeqSupported(cli)) {
+        if (count == 1)
+            writeToOutput(cli, escSeqDeleteChar);
+        else
+            writeCountedEscSeq(cli, escSeqDeleteChar, count);
+    } else {
+        // chars after removed ones are shifted by writing them again and
+        // freed chars are overwritten with spaces
+        writeCharsToOutput(cli, &impl->cmdBuffer[pos + count], tailLen);
+        for (uint16_t i = 0; i < count; ++i) {
+            writeCharToOutput(cli, ' ');
+        }
+        moveCursor(cli, impl->cursorPos, CURSOR_DIRECTION_BACKWARD);
+    }
+
+    memmove(&impl->cmdBuffer[pos], &impl->cmdBuffer[pos + count], (size_t) tailLen + 1);
+    impl->cmdSize = (uint16_t) (impl->cmdSize - count);
+    impl->cursorPos = tailLen;
+    // displayed autocompletion is shifted, so it is not valid anymore
+    impl->inputLineLength = (uint16_t) (impl->inputLineLength - count);
+    impl->liveAutocompletion = NULL;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
 }
 
-uint16_t embeddedCliRequiredSize(EmbeddedCliConfig *config) {
-    uint16_t bindingCount = (uint16_t) (config->maxBindingCount + cliInternalBindingCount);
-    return (uint16_t) (CLI_UINT_SIZE * (
-            BYTES_TO_CLI_UINTS(sizeof(EmbeddedCli)) +
-            BYTES_TO_CLI_UINTS(sizeof(EmbeddedCliImpl)) +
-            BYTES_TO_CLI_UINTS(config->rxBufferSize * sizeof(char)) +
-            BYTES_TO_CLI_UINTS(config->cmdBufferSize * sizeof(char)) +
-            BYTES_TO_CLI_UINTS(config->historyBufferSize * sizeof(char)) +
-            BYTES_TO_CLI_UINTS(bindingCount * sizeof(CliCommandBinding)) +
-            BYTES_TO_CLI_UINTS(bindingCount * sizeof(uint8_t))));
+static void onCharInput(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
+
+    // have to reserve two extra chars for command ending (used in tokenization)
+    if (impl->cmdSize + 2 >= impl->cmdMaxSize)
+        return;
+
+    size_t insertPos = strlen(impl->cmdBuffer) - impl->cursorPos;
+
+    memmove(&impl->cmdBuffer[insertPos + 1], &impl->cmdBuffer[insertPos], impl->cursorPos + 1);
+
+    ++impl->cmdSize;
+    impl->cmdBuffer[insertPos] = c;
+
+    if (impl->cursorPos > 0) {
+        if (isEscSeqSupported(cli))
+            writeToOutput(cli, escSeqInsertChar); // Insert Character
+        // displayed autocompletion is shifted, so it is not valid anymore
+        ++impl->inputLineLength;
+        impl->liveAutocompletion = NULL;
+    } else if (impl->inputLineLength < impl->cmdSize) {
+        // otherwise char is printed over displayed autocompletion
+        impl->inputLineLength = impl->cmdSize;
+    }
+
+    // when char is added to the end of non-empty command, autocompletion can
+    // only stay the same if there were no candidates or single candidate
+    // still matches (candidate is checked only while it is valid)
+    AutocompletedCommand *cached = &impl->autocompletion;
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED) &&
+        (impl->cursorPos > 0 || insertPos == 0 || cached->candidateCount > 1 ||
+         (cached->candidateCount == 1 &&
+          (insertPos >= cached->autocompletedLen || cached->firstCandidate[insertPos] != c))))
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+
+    writeCharToOutput(cli, c);
+
+    if (impl->cursorPos > 0 && !isEscSeqSupported(cli)) {
+        // chars after cursor are shifted by writing them again
+        writeCharsToOutput(cli, &impl->cmdBuffer[insertPos + 1], impl->cursorPos);
+        moveCursor(cli, impl->cursorPos, CURSOR_DIRECTION_BACKWARD);
+    }
 }
 
-EmbeddedCli *embeddedCliNew(EmbeddedCliConfig *config) {
-    EmbeddedCli *cli = NULL;
+static char onCharRunInput(EmbeddedCli *cli, ProcessBudget *budget, char c) {
+    PREPARE_IMPL(cli);
 
-    uint16_t bindingCount = (uint16_t) (config->maxBindingCount + cliInternalBindingCount);
+    // have to reserve two extra chars for command ending (used in tokenization)
+    if (impl->cmdSize + 2 >= impl->cmdMaxSize)
+        return c;
+
+    uint16_t start = impl->cmdSize;
+    impl->cmdBuffer[impl->cmdSize++] = c;
+
+    const char *data;
+    uint16_t len = fifoBufPeek(&impl->rxBuffer, &data);
+    uint16_t space = (uint16_t) (impl->cmdMaxSize - impl->cmdSize - 2);
+    if (len > space)
+        len = space;
+    if (budget->maxChars > 0 && len > budget->maxChars - budget->chars)
+        len = (uint16_t) (budget->maxChars - budget->chars);
+
+    uint16_t count = 0;
+    while (count < len && isDisplayableChar(data[count]))
+        ++count;
+
+    memcpy(&impl->cmdBuffer[impl->cmdSize], data, count);
+    impl->cmdSize = (uint16_t) (impl->cmdSize + count);
+    impl->cmdBuffer[impl->cmdSize] = '\0';
+    fifoBufConsume(&impl->rxBuffer, count);
+    budget->chars = (uint16_t) (budget->chars + count);
+
+    // chars are printed over displayed autocompletion
+    if (impl->inputLineLength < impl->cmdSize)
+        impl->inputLineLength = impl->cmdSize;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
 
-    size_t totalSize = embeddedCliRequiredSize(config);
+    writeCharsToOutput(cli, &impl->cmdBuffer[start], (uint16_t) (impl->cmdSize - start));
 
-    bool allocated = false;
-    if (config->cliBuffer == NULL) {
-        config->cliBuffer = (CLI_UINT *) malloc(totalSize); // malloc guarantees alignment.
-        if (config->cliBuffer == NULL)
-            return NULL;
-        allocated = true;
-    } else if (config->cliBufferSize < totalSize) {
-        return NULL;
+    return impl->cmdBuffer[impl->cmdSize - 1];
+}
+
+static bool takeInputChar(EmbeddedCli *cli, ProcessBudget *budget, char *c) {
+    PREPARE_IMPL(cli);
+
+    if (budget->maxChars > 0 && budget->chars >= budget->maxChars)
+        return false;
+    if (budget->maxMicros > 0 && budget->chars > 0 &&
+        budget->clock(cli) - budget->startMicros >= budget->maxMicros)
+        return false;
+    if (fifoBufAvailable(&impl->rxBuffer) == 0)
+        return false;
+
+    *c = fifoBufPop(&impl->rxBuffer);
+    ++budget->chars;
+    return true;
+}
+
+static void onControlInput(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
+
+    // process \r\n and \n\r as single \r\n command
+    if ((impl->lastChar == '\r' && c == '\n') ||
+        (impl->lastChar == '\n' && c == '\r'))
+        return;
+
+    InputKey key = INPUT_KEY_NONE;
+    if ((uint8_t) c < 32)
+        key = (InputKey) controlCharKeys[(uint8_t) c];
+    else if (c == 0x7F)
+        key = INPUT_KEY_BACKSPACE;
+
+    if (key == INPUT_KEY_ESCAPE)
+        impl->inputState = INPUT_STATE_ESCAPE;
+    else
+        onKeyInput(cli, key);
+}
+
+static void submitCommand(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    // try to autocomplete command and then process it (pasted command
+    // is executed as is)
+    if (!impl->pasting)
+        onAutocompleteRequest(cli, false);
+
+    writeToOutput(cli, lineBreak);
+
+    if (impl->cmdSize > 0) {
+        // executed command is recorded, so replayed output has context
+        scrollbackAppend(&impl->scrollback, impl->invitation, strlen(impl->invitation));
+        scrollbackAppend(&impl->scrollback, impl->cmdBuffer, impl->cmdSize);
+        scrollbackAppend(&impl->scrollback, lineBreak, strlen(lineBreak));
+        parseCommand(cli);
+    }
+    impl->cmdSize = 0;
+    impl->cmdBuffer[impl->cmdSize] = '\0';
+    impl->inputLineLength = 0;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+    impl->history.current = 0;
+    impl->cursorPos = 0;
+
+    // invitation is printed when generator is finished
+    if (impl->generator == NULL) {
+        finishFilter(cli);
+        finishProgress(cli);
+        writeToOutput(cli, impl->invitation);
     }
+}
 
-    CLI_UINT *buf = config->cliBuffer;
+static void parseCommand(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
 
-    memset(buf, 0, totalSize);
+    bool isEmpty = true;
 
-    cli = (EmbeddedCli *) buf;
-    buf += BYTES_TO_CLI_UINTS(sizeof(EmbeddedCli));
+    for (int i = 0; i < impl->cmdSize; ++i) {
+        if (impl->cmdBuffer[i] != ' ') {
+            isEmpty = false;
+            break;
+        }
+    }
+    // do not process empty commands
+    if (isEmpty)
+        return;
+    // push command to history before buffer is modified
+    historyPut(&impl->history, impl->cmdBuffer);
 
-    cli->_impl = (EmbeddedCliImpl *) buf;
-    buf += BYTES_TO_CLI_UINTS(sizeof(EmbeddedCliImpl));
+    // we keep two last bytes in cmd buffer reserved so cmdSize is always by 2
+    // less than cmdMaxSize
+    executeCommand(cli, impl->cmdBuffer, impl->cmdSize);
+}
 
+static void executeCommand(EmbeddedCli *cli, char *buffer, uint16_t size) {
     PREPARE_IMPL(cli);
-    impl->rxBuffer.buf = (char *) buf;
-    buf += BYTES_TO_CLI_UINTS(config->rxBufferSize * sizeof(char));
 
-    impl->cmdBuffer = (char *) buf;
-    buf += BYTES_TO_CLI_UINTS(config->cmdBufferSize * sizeof(char));
+    OutputFilter filter;
+    if (!parseFilter(cli, buffer, &size, &filter))
+        return;
 
-    impl->bindings = (CliCommandBinding *) buf;
-    buf += BYTES_TO_CLI_UINTS(bindingCount * sizeof(CliCommandBinding));
+    char *cmdName = NULL;
+    char *cmdArgs = NULL;
+    bool nameFinished = false;
 
-    impl->bindingsFlags = (uint8_t *) buf;
-    buf += BYTES_TO_CLI_UINTS(bindingCount);
+    // find command name and command args inside command buffer
+    for (int i = 0; i < size; ++i) {
+        char c = buffer[i];
 
-    impl->history.buf = (char *) buf;
-    impl->history.bufferSize = config->historyBufferSize;
+        if (c == ' ') {
+            // all spaces between name and args are filled with zeros
+            // so name is a correct null-terminated string
+            if (cmdArgs == NULL)
+                buffer[i] = '\0';
+            if (cmdName != NULL)
+                nameFinished = true;
 
-    if (allocated)
-        SET_FLAG(impl->flags, CLI_FLAG_ALLOCATED);
+        } else if (cmdName == NULL) {
+            cmdName = &buffer[i];
+        } else if (cmdArgs == NULL && nameFinished) {
+            cmdArgs = &buffer[i];
+        }
+    }
 
-    if (config->enableAutoComplete)
-        SET_FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_ENABLED);
+    buffer[size + 1] = '\0';
 
-    impl->rxBuffer.size = config->rxBufferSize;
-    impl->rxBuffer.front = 0;
-    impl->rxBuffer.back = 0;
-    impl->cmdMaxSize = config->cmdBufferSize;
-    impl->bindingsCount = 0;
-    impl->maxBindingsCount = (uint16_t) (config->maxBindingCount + cliInternalBindingCount);
-    impl->lastChar = '\0';
-    impl->invitation = config->invitation;
-    impl->cursorPos = 0;
+    if (cmdName == NULL)
+        return;
 
-    initInternalBindings(cli);
+    // try to find command in bindings
+    for (int i = 0; i < impl->bindingsCount; ++i) {
+        if (strcmp(cmdName, impl->bindings[i].name) == 0) {
+            if (impl->bindings[i].binding == NULL)
+                break;
 
-    return cli;
-}
+            if (impl->bindings[i].tokenizeArgs)
+                embeddedCliTokenizeArgs(cmdArgs);
+            // currently, output is blank line, so we can just print directly
+            SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+            impl->filter = filter;
+            // check if help was requested (help is printed when no other options are set)
+            if (cmdArgs != NULL && (strcmp(cmdArgs, "-h") == 0 || strcmp(cmdArgs, "--help") == 0)) {
+                printBindingHelp(cli, &impl->bindings[i]);
+            } else {
+                impl->bindings[i].binding(cli, cmdArgs, impl->bindings[i].context);
+            }
+            UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+            return;
+        }
+    }
 
-EmbeddedCli *embeddedCliNewDefault(void) {
-    return embeddedCliNew(embeddedCliDefaultConfig());
+    // command not found in bindings or binding was null
+    // try to call default callback
+    if (cli->onCommand != NULL) {
+        CliCommand command;
+        command.name = cmdName;
+        command.args = cmdArgs;
+
+        // currently, output is blank line, so we can just print directly
+        SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+        impl->filter = filter;
+        cli->onCommand(cli, &command);
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    } else {
+        SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+        onUnknownCommand(cli, cmdName);
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    }
 }
 
-void embeddedCliReceiveChar(EmbeddedCli *cli, char c) {
+static void captureChars(EmbeddedCli *cli, const char *buf, size_t len) {
     PREPARE_IMPL(cli);
+    Capture *capture = &impl->capture;
 
-    if (!fifoBufPush(&impl->rxBuffer, c)) {
-        SET_FLAG(impl->flags, CLI_FLAG_OVERFLOW);
+    size_t space = (size_t) (capture->capacity - capture->length);
+    if (len > space) {
+        capture->truncated = true;
+        len = space;
     }
+    memcpy(&capture->buf[capture->length], buf, len);
+    capture->length = (uint16_t) (capture->length + len);
 }
 
-void embeddedCliProcess(EmbeddedCli *cli) {
-    if (cli->writeChar == NULL)
+static void beginPrint(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    embeddedCliBeginOutput(cli);
+
+    // filter is enabled after everything that is not part of printed text
+    uint16_t filtering = applyFilter(cli) ? CLI_FLAG_FILTERING : 0u;
+    // captured output doesn't change screen
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_SUPPRESSED) || IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING)) {
+        impl->flags |= filtering;
         return;
+    }
 
-    PREPARE_IMPL(cli);
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_PROGRESS_SHOWN))
+        clearProgress(cli);
 
+    // remove chars for autocompletion and live command (unless they are
+    // already removed by previous coalesced print)
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT) &&
+        !IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN)) {
+        // Save cursor position
+        uint16_t cursorPosSave = impl->cursorPos;
 
-    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_INIT_COMPLETE)) {
-        SET_FLAG(impl->flags, CLI_FLAG_INIT_COMPLETE);
-        writeToOutput(cli, impl->invitation);
+        clearCurrentLine(cli);
+        SET_FLAG(impl->flags, CLI_FLAG_INPUT_HIDDEN);
+
+        // Restore cursor position
+        impl->cursorPos = cursorPosSave;
     }
 
-    while (fifoBufAvailable(&impl->rxBuffer)) {
-        char c = fifoBufPop(&impl->rxBuffer);
+    SET_FLAG(impl->flags, CLI_FLAG_RECORDING);
+    impl->flags |= filtering;
+}
 
-        if (IS_FLAG_SET(impl->flags, CLI_FLAG_ESCAPE_MODE)) {
-            onEscapedInput(cli, c);
-        } else if (impl->lastChar == 0x1B && c == '[') {
-            //enter escape mode
-            SET_FLAG(impl->flags, CLI_FLAG_ESCAPE_MODE);
-        } else if (isControlChar(c)) {
-            onControlInput(cli, c);
-        } else if (isDisplayableChar(c)) {
-            onCharInput(cli, c);
-        }
+static void endPrint(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
 
-        printLiveAutocompletion(cli);
+    writeToOutput(cli, lineBreak);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_RECORDING | CLI_FLAG_FILTERING);
 
-        impl->lastChar = c;
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_SUPPRESSED) || IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING)) {
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_SUPPRESSED);
+        embeddedCliEndOutput(cli);
+        return;
     }
 
-    // discard unfinished command if overflow happened
-    if (IS_FLAG_SET(impl->flags, CLI_FLAG_OVERFLOW)) {
-        impl->cmdSize = 0;
-        impl->cmdBuffer[impl->cmdSize] = '\0';
-        UNSET_U8FLAG(impl->flags, CLI_FLAG_OVERFLOW);
+    // progress is always kept below printed lines
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_PROGRESS_SHOWN)) {
+        char progress[CLI_PROGRESS_LENGTH];
+        formatProgress(progress, impl->progress);
+        writeCharsToOutput(cli, progress, CLI_PROGRESS_LENGTH);
+    }
+
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN)) {
+        if (isCoalesceWindowEnabled(cli))
+            impl->lastPrintMs = cli->getTimeMs(cli);
+        else if (impl->printBatchDepth == 0)
+            restoreInputLine(cli);
     }
+
+    embeddedCliEndOutput(cli);
 }
 
-bool embeddedCliAddBinding(EmbeddedCli *cli, CliCommandBinding binding) {
+static void restoreInputLine(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
-    if (impl->bindingsCount == impl->maxBindingsCount)
-        return false;
 
-    impl->bindings[impl->bindingsCount] = binding;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_INPUT_HIDDEN);
 
-    ++impl->bindingsCount;
-    return true;
+    // command is printed back only when output of generator is finished
+    if (impl->generator != NULL) {
+        if (impl->pager.waiting)
+            writeToOutput(cli, pagerPrompt);
+        return;
+    }
+
+    writeToOutput(cli, impl->invitation);
+    writeToOutput(cli, impl->cmdBuffer);
+    impl->inputLineLength = impl->cmdSize;
+    moveCursor(cli, impl->cursorPos, CURSOR_DIRECTION_BACKWARD);
+
+    printLiveAutocompletion(cli);
 }
 
-void embeddedCliPrint(EmbeddedCli *cli, const char *string) {
-    if (cli->writeChar == NULL)
-        return;
+static bool isCoalesceWindowEnabled(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    return impl->printCoalesceMs > 0 && cli->getTimeMs != NULL;
+}
 
+static void setupStatusArea(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
 
-    // Save cursor position
-    uint16_t cursorPosSave = impl->cursorPos;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_STATUS_AREA);
+    if (impl->statusLineCount == 0 || impl->terminalHeight <= impl->statusLineCount ||
+        !IS_FLAG_SET(impl->flags, CLI_FLAG_INIT_COMPLETE) || !isOutputAvailable(cli) ||
+        !isEscSeqSupported(cli))
+        return;
 
-    // remove chars for autocompletion and live command
-    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT))
-        clearCurrentLine(cli);
+    bool wasHidden = IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN);
+    beginPrint(cli);
+    // status area is not printed output, so it is not recorded (and print
+    // is not finished with endPrint that stops recording)
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_RECORDING);
+
+    // scroll content up, so current line is not covered by status lines
+    // (only once, terminal size can be reported many times)
+    if (impl->statusLinesScrolled < impl->statusLineCount) {
+        uint8_t count = (uint8_t) (impl->statusLineCount - impl->statusLinesScrolled);
+        for (uint8_t i = 0; i < count; ++i) {
+            writeToOutput(cli, lineBreak);
+        }
+        writeFormatted(cli, "\x1B[%uA", (unsigned int) count);
+        impl->statusLinesScrolled = impl->statusLineCount;
+    }
+    writeToOutput(cli, escSeqCursorSave);
+    writeFormatted(cli, "\x1B[1;%ur", (unsigned int) (impl->terminalHeight - impl->statusLineCount));
+    writeToOutput(cli, escSeqCursorRestore);
 
-    // Restore cursor position
-    impl->cursorPos = cursorPosSave;
+    SET_FLAG(impl->flags, CLI_FLAG_STATUS_AREA);
+    for (uint8_t i = 0; i < impl->statusLineCount; ++i) {
+        drawStatusLine(cli, i, &impl->statusLines[i * (impl->statusLineLength + 1)], true);
+    }
 
-    // print provided string
-    writeToOutput(cli, string);
-    writeToOutput(cli, lineBreak);
+    if (!wasHidden && IS_FLAG_SET(impl->flags, CLI_FLAG_INPUT_HIDDEN))
+        restoreInputLine(cli);
+    embeddedCliEndOutput(cli);
+}
 
-    // print current command back to screen
-    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT)) {
-        writeToOutput(cli, impl->invitation);
-        writeToOutput(cli, impl->cmdBuffer);
-        impl->inputLineLength = impl->cmdSize;
-        moveCursor(cli, impl->cursorPos, CURSOR_DIRECTION_BACKWARD);
+static void drawStatusLine(EmbeddedCli *cli, uint8_t index, const char *text, bool redraw) {
+    PREPARE_IMPL(cli);
 
-        printLiveAutocompletion(cli);
+    const char *displayed = &impl->statusLines[index * (impl->statusLineLength + 1)];
+    uint16_t displayedLen = (uint16_t) strlen(displayed);
+    uint16_t len = (uint16_t) strlen(text);
+    if (len > impl->statusLineLength)
+        len = impl->statusLineLength;
+
+    // find range of chars that differ from displayed text
+    uint16_t first = 0;
+    if (!redraw) {
+        while (first < len && first < displayedLen && text[first] == displayed[first])
+            ++first;
+        if (first == len && len == displayedLen)
+            return;
     }
+    uint16_t last = len;
+    if (!redraw && len == displayedLen) {
+        while (last > first && text[last - 1] == displayed[last - 1])
+            --last;
+    }
+
+    writeToOutput(cli, escSeqCursorSave);
+    writeFormatted(cli, "\x1B[%u;%uH",
+                   (unsigned int) (impl->terminalHeight - impl->statusLineCount + 1 + index),
+                   (unsigned int) (first + 1));
+    writeCharsToOutput(cli, &text[first], (size_t) (last - first));
+    if (redraw || displayedLen > len) {
+        if (isPartialRedrawSupported(cli))
+            writeToOutput(cli, escSeqEraseLine);
+        else if (displayedLen > len)
+            writePadding(cli, ' ', (size_t) (displayedLen - len));
+    }
+    writeToOutput(cli, escSeqCursorRestore);
 }
 
-void embeddedCliFree(EmbeddedCli *cli) {
-    PREPARE_IMPL(cli);
-    if (IS_FLAG_SET(impl->flags, CLI_FLAG_ALLOCATED)) {
-        // allocation is done in single call to malloc, so need only single free
-        free(cli);
+static void formatProgress(char *buffer, uint8_t percent) {
+    uint8_t filled = (uint8_t) (percent * CLI_PROGRESS_BAR_WIDTH / 100);
+
+    buffer[0] = '[';
+    for (uint8_t i = 0; i < CLI_PROGRESS_BAR_WIDTH; ++i) {
+        buffer[1 + i] = i < filled ? '#' : '.';
+    }
+    buffer[CLI_PROGRESS_BAR_WIDTH + 1] = ']';
+    buffer[CLI_PROGRESS_BAR_WIDTH + 2] = ' ';
+
+    // percent is right aligned in 3 chars
+    char digits[CLI_NUMBER_BUFFER_SIZE];
+    uint8_t len = formatUnsigned(digits, percent, 10, false);
+    for (uint8_t i = 0; i < 3; ++i) {
+        buffer[CLI_PROGRESS_BAR_WIDTH + 3 + i] = i + len < 3 ? ' ' : digits[i + len - 3];
     }
+    buffer[CLI_PROGRESS_LENGTH - 1] = '%';
 }
 
-void embeddedCliTokenizeArgs(char *args) {
-    if (args == NULL)
+static void clearProgress(EmbeddedCli *cli) {
+    writeCharToOutput(cli, '\r');
+    if (isPartialRedrawSupported(cli)) {
+        writeToOutput(cli, escSeqEraseLine);
+    } else {
+        writePadding(cli, ' ', CLI_PROGRESS_LENGTH);
+        writeCharToOutput(cli, '\r');
+    }
+}
+
+static void scrollbackAppend(Scrollback *scrollback, const char *buf, size_t len) {
+    if (scrollback->size == 0 || len == 0)
         return;
 
-    // for now only space, but can add more later
-    const char *separators = " ";
+    // char before oldest kept one is lost when buffer wraps, so remember
+    // whether it was line break
+    size_t total = scrollback->length + len;
+    if (total > scrollback->size) {
+        size_t prev = total - scrollback->size - 1;
+        size_t oldest = (size_t) scrollback->head + scrollback->size - scrollback->length;
+        char c = prev < scrollback->length ? scrollback->buf[(oldest + prev) % scrollback->size] :
+                 buf[prev - scrollback->length];
+        scrollback->lineStart = c == '\n';
+    }
 
-    // indicates that arg is quoted so separators are copied as is
-    bool quotesEnabled = false;
-    // indicates that previous char was a slash, so next char is copied as is
-    bool escapeActivated = false;
-    int insertPos = 0;
+    // only the tail fits when text is longer than whole buffer
+    if (len > scrollback->size) {
+        buf += len - scrollback->size;
+        len = scrollback->size;
+    }
 
-    int i = 0;
-    char currentChar;
-    while ((currentChar = args[i]) != '\0') {
-        ++i;
+    size_t first = scrollback->size - scrollback->head;
+    if (first > len)
+        first = len;
+    memcpy(&scrollback->buf[scrollback->head], buf, first);
+    memcpy(scrollback->buf, &buf[first], len - first);
 
-        if (escapeActivated) {
-            escapeActivated = false;
-        } else if (currentChar == '\\') {
-            escapeActivated = true;
-            continue;
-        } else if (currentChar == '"') {
-            quotesEnabled = !quotesEnabled;
-            currentChar = '\0';
-        } else if (!quotesEnabled && strchr(separators, currentChar) != NULL) {
-            currentChar = '\0';
-        }
+    scrollback->head = (uint16_t) ((scrollback->head + len) % scrollback->size);
+    scrollback->length = (uint16_t) (total < scrollback->size ? total : scrollback->size);
+}
 
-        // null chars are only copied once and not copied to the beginning
-        if (currentChar != '\0' || (insertPos > 0 && args[insertPos - 1] != '\0')) {
-            args[insertPos] = currentChar;
-            ++insertPos;
+static void printScrollback(EmbeddedCli *cli, Scrollback *scrollback, uint16_t bytes, uint16_t lines) {
+    PREPARE_IMPL(cli);
+
+    if (!isOutputAvailable(cli) || scrollback->length == 0)
+        return;
+
+    uint16_t count = scrollback->length;
+    if (bytes > 0 && bytes < count)
+        count = bytes;
+    if (lines > 0) {
+        // line break at the very end finishes last line
+        uint16_t len = 0;
+        while (len < count) {
+            char c = scrollback->buf[(scrollback->head + scrollback->size - len - 1) % scrollback->size];
+            if (c == '\n' && len > 0 && --lines == 0)
+                break;
+            ++len;
         }
+        count = len;
+    }
+    // skip partial line at the beginning (when replay is limited or oldest
+    // line is partially overwritten after buffer wrapped)
+    if (count < scrollback->length || !scrollback->lineStart) {
+        // char before the oldest one is lost, it is known to be not line break
+        if (count == scrollback->length)
+            --count;
+        while (count > 0 && scrollback->buf[(scrollback->head + scrollback->size - count - 1) % scrollback->size] != '\n')
+            --count;
     }
 
-    // make args double null-terminated source buffer must be big enough to contain extra spaces
-    args[insertPos] = '\0';
-    args[insertPos + 1] = '\0';
+    // recorded output always ends with line break, it is written by endPrint
+    uint16_t lineBreakLen = (uint16_t) strlen(lineBreak);
+    if (count <= lineBreakLen)
+        return;
+    count = (uint16_t) (count - lineBreakLen);
+    uint16_t start = (uint16_t) ((scrollback->head + scrollback->size - count - lineBreakLen) % scrollback->size);
+
+    beginPrint(cli);
+    // replayed output is not recorded again
+    if (scrollback == &impl->scrollback)
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_RECORDING);
+    uint16_t first = (uint16_t) (scrollback->size - start);
+    if (first > count)
+        first = count;
+    writeCharsToOutput(cli, &scrollback->buf[start], first);
+    writeCharsToOutput(cli, scrollback->buf, (size_t) (count - first));
+    endPrint(cli);
 }
 
-const char *embeddedCliGetToken(const char *tokenizedStr, uint16_t pos) {
-    uint16_t i = getTokenPosition(tokenizedStr, pos);
-
-    if (i != CLI_TOKEN_NPOS)
-        return &tokenizedStr[i];
-    else
-        return NULL;
-}
+static void finishProgress(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
 
-char *embeddedCliGetTokenVariable(char *tokenizedStr, uint16_t pos) {
-    uint16_t i = getTokenPosition(tokenizedStr, pos);
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_PROGRESS_SHOWN))
+        return;
 
-    if (i != CLI_TOKEN_NPOS)
-        return &tokenizedStr[i];
-    else
-        return NULL;
+    writeToOutput(cli, lineBreak);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_PROGRESS_SHOWN);
 }
 
-uint16_t embeddedCliFindToken(const char *tokenizedStr, const char *token) {
-    if (tokenizedStr == NULL || token == NULL)
-        return 0;
+static bool parseFilter(EmbeddedCli *cli, char *buffer, uint16_t *size, OutputFilter *filter) {
+    PREPARE_IMPL(cli);
 
-    uint16_t size = embeddedCliGetTokenCount(tokenizedStr);
-    for (uint16_t i = 1; i <= size; ++i) {
-        if (strcmp(embeddedCliGetToken(tokenizedStr, i), token) == 0)
-            return i;
+    filter->type = FILTER_NONE;
+    filter->pattern = NULL;
+    filter->limit = CLI_FILTER_DEFAULT_LINES;
+    filter->lines = 0;
+
+    // pipe inside quotes or escaped with backslash is part of arguments
+    bool quoted = false;
+    uint16_t pipePos = *size;
+    for (uint16_t i = 0; i < *size; ++i) {
+        char c = buffer[i];
+        if (c == '\\') {
+            ++i;
+        } else if (c == '"') {
+            quoted = !quoted;
+        } else if (c == '|' && !quoted) {
+            pipePos = i;
+            break;
+        }
     }
+    if (pipePos == *size)
+        return true;
 
-    return 0;
+    char *name = &buffer[pipePos + 1];
+    while (*name == ' ')
+        ++name;
+    char *arg = name;
+    while (*arg != ' ' && *arg != '\0')
+        ++arg;
+    if (*arg != '\0') {
+        *arg = '\0';
+        ++arg;
+        while (*arg == ' ')
+            ++arg;
+    }
+    char *argEnd = arg + strlen(arg);
+    while (argEnd > arg && argEnd[-1] == ' ')
+        --argEnd;
+    *argEnd = '\0';
+
+    if (strcmp(name, "grep") == 0) {
+        filter->type = FILTER_GREP;
+        filter->pattern = arg;
+    } else if (strcmp(name, "head") == 0 || strcmp(name, "tail") == 0) {
+        filter->type = name[0] == 'h' ? FILTER_HEAD : FILTER_TAIL;
+        if (*arg != '\0') {
+            uint32_t limit = 0;
+            for (const char *c = arg; *c != '\0'; ++c) {
+                if (*c < '0' || *c > '9' || limit > UINT16_MAX) {
+                    writeFormatted(cli, "Filter \"%s\" receives number of lines", name);
+                    writeToOutput(cli, lineBreak);
+                    return false;
+                }
+                limit = limit * 10 + (uint32_t) (*c - '0');
+            }
+            filter->limit = (uint16_t) (limit < UINT16_MAX ? limit : UINT16_MAX);
+        }
+        if (filter->type == FILTER_TAIL) {
+            if (impl->tailLines.size == 0) {
+                writeToOutput(cli, "Filter \"tail\" requires tail buffer");
+                writeToOutput(cli, lineBreak);
+                return false;
+            }
+            impl->tailLines.head = 0;
+            impl->tailLines.length = 0;
+            impl->tailLines.lineStart = true;
+        }
+    } else if (strcmp(name, "count") == 0) {
+        filter->type = FILTER_COUNT;
+    } else {
+        writeFormatted(cli, "Unknown filter: \"%s\"", name);
+        writeToOutput(cli, lineBreak);
+        return false;
+    }
+
+    // pattern stays in command buffer after pipe, so only command is cut
+    while (pipePos > 0 && buffer[pipePos - 1] == ' ')
+        --pipePos;
+    buffer[pipePos] = '\0';
+    *size = pipePos;
+    return true;
 }
 
-uint16_t embeddedCliGetTokenCount(const char *tokenizedStr) {
-    if (tokenizedStr == NULL || tokenizedStr[0] == '\0')
-        return 0;
+static bool beginLineMatch(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    OutputFilter *filter = &impl->filter;
 
-    int i = 0;
-    uint16_t tokenCount = 1;
-    while (true) {
-        if (tokenizedStr[i] == '\0') {
-            if (tokenizedStr[i + 1] == '\0')
-                break;
-            ++tokenCount;
-        }
-        ++i;
-    }
+    if (filter->type != FILTER_GREP || !IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT))
+        return false;
 
-    return tokenCount;
+    filter->segment = 0;
+    while (filter->pattern[filter->segment] == '*')
+        ++filter->segment;
+    filter->matched = 0;
+    filter->found = filter->pattern[filter->segment] == '\0';
+    SET_FLAG(impl->flags, CLI_FLAG_MATCHING);
+    return true;
 }
 
-static void navigateHistory(EmbeddedCli *cli, bool navigateUp) {
+static void endLineMatch(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
-    if (impl->history.itemsCount == 0 ||
-        (navigateUp && impl->history.current == impl->history.itemsCount) ||
-        (!navigateUp && impl->history.current == 0))
-        return;
 
-    clearCurrentLine(cli);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_MATCHING);
+    if (impl->filter.found)
+        SET_FLAG(impl->flags, CLI_FLAG_LINE_MATCHED);
+}
 
-    writeToOutput(cli, impl->invitation);
+static void matchChars(OutputFilter *filter, const char *buf, size_t len) {
+    for (size_t i = 0; i < len && !filter->found; ++i) {
+        const char *segment = &filter->pattern[filter->segment];
+
+        // find longest prefix of segment that is suffix of matched text and
+        // new char (as in KMP, but without precomputed table)
+        uint16_t matched = (uint16_t) (filter->matched + 1);
+        while (matched > 0 && (segment[matched - 1] != buf[i] ||
+                               memcmp(segment, &segment[filter->matched + 1 - matched], matched - 1u) != 0))
+            --matched;
+        filter->matched = matched;
+
+        if (segment[matched] == '*' || segment[matched] == '\0') {
+            // segment is found, next one is searched after it
+            filter->segment = (uint16_t) (filter->segment + matched);
+            while (filter->pattern[filter->segment] == '*')
+                ++filter->segment;
+            filter->matched = 0;
+            filter->found = filter->pattern[filter->segment] == '\0';
+        }
+    }
+}
 
-    if (navigateUp)
-        ++impl->history.current;
-    else
-        --impl->history.current;
+static bool applyFilter(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    OutputFilter *filter = &impl->filter;
 
-    const char *item = historyGet(&impl->history, impl->history.current);
-    // simple way to handle empty command the same way as others
-    if (item == NULL)
-        item = "";
-    uint16_t len = (uint16_t) strlen(item);
-    memcpy(impl->cmdBuffer, item, len);
-    impl->cmdBuffer[len] = '\0';
-    impl->cmdSize = len;
+    bool lineMatched = IS_FLAG_SET(impl->flags, CLI_FLAG_LINE_MATCHED);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_LINE_MATCHED);
+    if (filter->type == FILTER_NONE || !IS_FLAG_SET(impl->flags, CLI_FLAG_DIRECT_PRINT))
+        return false;
 
-    writeToOutput(cli, impl->cmdBuffer);
-    impl->inputLineLength = impl->cmdSize;
-    impl->cursorPos = 0;
+    bool passed = false;
+    if (filter->type == FILTER_GREP)
+        passed = lineMatched;
+    else if (filter->type == FILTER_HEAD)
+        passed = filter->lines < filter->limit;
 
-    printLiveAutocompletion(cli);
+    if (!passed)
+        SET_FLAG(impl->flags, CLI_FLAG_SUPPRESSED);
+    return true;
+}
+
+static void filterOutput(EmbeddedCli *cli, const char *buf, size_t len) {
+    PREPARE_IMPL(cli);
+    OutputFilter *filter = &impl->filter;
+
+    if (filter->type == FILTER_TAIL)
+        scrollbackAppend(&impl->tailLines, buf, len);
+
+    // passed lines are written as usual
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_FILTERING);
+    while (len > 0) {
+        const char *lineEnd = (const char *) memchr(buf, '\n', len);
+        size_t lineLen = lineEnd != NULL ? (size_t) (lineEnd - buf) + 1 : len;
+
+        bool passed = !IS_FLAG_SET(impl->flags, CLI_FLAG_SUPPRESSED);
+        if (filter->type == FILTER_HEAD)
+            passed = filter->lines < filter->limit;
+        if (passed)
+            writeCharsToOutput(cli, buf, lineLen);
+
+        if (lineEnd != NULL && filter->lines < UINT16_MAX)
+            ++filter->lines;
+        buf += lineLen;
+        len -= lineLen;
+    }
+    SET_FLAG(impl->flags, CLI_FLAG_FILTERING);
 }
 
-static void onEscapedInput(EmbeddedCli *cli, char c) {
+static void finishFilter(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
+    OutputFilter *filter = &impl->filter;
+
+    OutputFilterType type = filter->type;
+    filter->type = FILTER_NONE;
+
+    // result is printed as output of command
+    SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    if (type == FILTER_COUNT)
+        embeddedCliPrintf(cli, "%u", (unsigned int) filter->lines);
+    else if (type == FILTER_TAIL && filter->limit > 0)
+        printScrollback(cli, &impl->tailLines, 0, filter->limit);
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+}
 
-    if (c >= 64 && c <= 126) {
-        // handle escape sequence
-        UNSET_U8FLAG(impl->flags, CLI_FLAG_ESCAPE_MODE);
+static void formatToOutput(EmbeddedCli *cli, const char *format, va_list args) {
+    formatCells(cli, format, args, NULL, false);
+}
 
-        if (c == 'A' || c == 'B') {
-            // treat \e[..A as cursor up and \e[..B as cursor down
-            // there might be extra chars between [ and A/B, just ignore them
-            navigateHistory(cli, c == 'A');
-        }
+static void formatCells(EmbeddedCli *cli, const char *format, va_list args,
+                        EmbeddedCliTable *table, bool measure) {
+    const char *literal = format;
+    uint8_t column = 0;
 
-        if (c == 'C' && impl->cursorPos > 0) {
-            impl->cursorPos--;
-            writeToOutput(cli, escSeqCursorRight);
+    while (*format != '\0') {
+        if (*format != '%') {
+            ++format;
+            continue;
+        }
+        // write everything before specifier as is
+        if (!measure)
+            writeCharsToOutput(cli, literal, (size_t) (format - literal));
+        const char *specifierStart = format;
+        ++format;
+
+        bool leftAlign = false;
+        bool zeroPad = false;
+        while (*format == '-' || *format == '0') {
+            if (*format == '-')
+                leftAlign = true;
+            else
+                zeroPad = true;
+            ++format;
         }
 
-        if (c == 'D' && impl->cursorPos < strlen(impl->cmdBuffer)) {
-            impl->cursorPos++;
-            writeToOutput(cli, escSeqCursorLeft);
+        size_t width = 0;
+        if (*format == '*') {
+            int w = va_arg(args, int);
+            if (w < 0) {
+                leftAlign = true;
+                w = -w;
+            }
+            width = (size_t) w;
+            ++format;
+        } else {
+            while (*format >= '0' && *format <= '9') {
+                width = width * 10 + (size_t) (*format - '0');
+                ++format;
+            }
         }
-    }
-}
 
-static void onCharInput(EmbeddedCli *cli, char c) {
-    PREPARE_IMPL(cli);
+        bool hasPrecision = false;
+        size_t precision = 0;
+        if (*format == '.') {
+            hasPrecision = true;
+            ++format;
+            if (*format == '*') {
+                int p = va_arg(args, int);
+                precision = p < 0 ? 0 : (size_t) p;
+                ++format;
+            } else {
+                while (*format >= '0' && *format <= '9') {
+                    precision = precision * 10 + (size_t) (*format - '0');
+                    ++format;
+                }
+            }
+        }
 
-    // have to reserve two extra chars for command ending (used in tokenization)
-    if (impl->cmdSize + 2 >= impl->cmdMaxSize)
-        return;
+        // 'c' is used for "hh" and 'q' for "ll"
+        char modifier = '\0';
+        if (*format == 'l' || *format == 'h' || *format == 'z' || *format == 'L') {
+            modifier = *format;
+            ++format;
+            if (modifier == 'h' && *format == 'h') {
+                modifier = 'c';
+                ++format;
+            } else if (modifier == 'l' && *format == 'l') {
+                modifier = 'q';
+                ++format;
+            }
+        }
 
-    size_t insertPos = strlen(impl->cmdBuffer) - impl->cursorPos;
+        char numBuffer[CLI_NUMBER_BUFFER_SIZE];
+        const char *prefix = "";
+        const char *str = numBuffer;
+        size_t len = 0;
 
-    memmove(&impl->cmdBuffer[insertPos + 1], &impl->cmdBuffer[insertPos], impl->cursorPos + 1);
+        char specifier = *format;
+        if (specifier == '\0')
+            break;
+        ++format;
+
+        switch (specifier) {
+            case 'd':
+            case 'i': {
+                if (modifier == 'q') {
+                    (void) va_arg(args, long long);
+                    str = specifierStart;
+                    len = (size_t) (format - specifierStart);
+                    break;
+                }
+                long value;
+                if (modifier == 'l')
+                    value = va_arg(args, long);
+                else if (modifier == 'z')
+                    value = (long) va_arg(args, size_t);
+                else if (modifier == 'h')
+                    value = (short) va_arg(args, int);
+                else if (modifier == 'c')
+                    value = (signed char) va_arg(args, int);
+                else
+                    value = va_arg(args, int);
+                unsigned long magnitude = (unsigned long) value;
+                if (value < 0) {
+                    prefix = "-";
+                    magnitude = 0UL - magnitude;
+                }
+                len = formatUnsigned(numBuffer, magnitude, 10, false);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                if (modifier == 'q') {
+                    (void) va_arg(args, unsigned long long);
+                    str = specifierStart;
+                    len = (size_t) (format - specifierStart);
+                    break;
+                }
+                unsigned long value;
+                if (modifier == 'l')
+                    value = va_arg(args, unsigned long);
+                else if (modifier == 'z')
+                    value = (unsigned long) va_arg(args, size_t);
+                else if (modifier == 'h')
+                    value = (unsigned short) va_arg(args, unsigned int);
+                else if (modifier == 'c')
+                    value = (unsigned char) va_arg(args, unsigned int);
+                else
+                    value = va_arg(args, unsigned int);
+                len = formatUnsigned(numBuffer, value, specifier == 'u' ? 10 : 16, specifier == 'X');
+                break;
+            }
+            case 'p':
+                prefix = "0x";
+                len = formatPointer(numBuffer, (uintptr_t) va_arg(args, void *));
+                break;
+            case 'c':
+                numBuffer[0] = (char) va_arg(args, int);
+                len = 1;
+                break;
+            case 's':
+                str = va_arg(args, const char *);
+                if (str == NULL)
+                    str = "(null)";
+                while (str[len] != '\0' && (!hasPrecision || len < precision))
+                    ++len;
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (modifier == 'L')
+                    (void) va_arg(args, long double);
+                else
+                    (void) va_arg(args, double);
+                str = specifierStart;
+                len = (size_t) (format - specifierStart);
+                break;
+            case '%':
+                numBuffer[0] = '%';
+                len = 1;
+                break;
+            default:
+                // argument type of unknown specifier is unknown too, so it
+                // is printed as is without taking argument
+                str = specifierStart;
+                len = (size_t) (format - specifierStart);
+                break;
+        }
 
-    ++impl->cmdSize;
-    ++impl->inputLineLength;
-    impl->cmdBuffer[insertPos] = c;
+        size_t prefixLen = strlen(prefix);
+        size_t padding = width > len + prefixLen ? width - len - prefixLen : 0;
+
+        size_t cellPadding = 0;
+        bool cellLeftAlign = false;
+        if (table != NULL && specifier != '%' && column < table->columnCount) {
+            EmbeddedCliTableColumn *tableColumn = &table->columns[column];
+            size_t fieldLen = prefixLen + padding + len;
+            ++column;
+            if (measure) {
+                if (fieldLen > tableColumn->width)
+                    tableColumn->width = (uint8_t) (fieldLen < UINT8_MAX ? fieldLen : UINT8_MAX);
+                literal = format;
+                continue;
+            }
+            if (column > 1)
+                writeToOutput(cli, tableSeparator);
+            cellPadding = tableColumn->width > fieldLen ? tableColumn->width - fieldLen : 0;
+            cellLeftAlign = tableColumn->align == CLI_ALIGN_LEFT;
+            // last column is not padded, so there are no trailing spaces
+            if (cellLeftAlign && column == table->columnCount)
+                cellPadding = 0;
+        } else if (measure) {
+            literal = format;
+            continue;
+        }
 
-    if (impl->cursorPos > 0)
-        writeToOutput(cli, escSeqInsertChar); // Insert Character
+        if (!cellLeftAlign)
+            writePadding(cli, ' ', cellPadding);
+        if (!leftAlign && !zeroPad)
+            writePadding(cli, ' ', padding);
+        writeCharsToOutput(cli, prefix, prefixLen);
+        if (!leftAlign && zeroPad)
+            writePadding(cli, '0', padding);
+        writeCharsToOutput(cli, str, len);
+        if (leftAlign)
+            writePadding(cli, ' ', padding);
+        if (cellLeftAlign)
+            writePadding(cli, ' ', cellPadding);
+
+        literal = format;
+    }
 
-    cli->writeChar(cli, c);
+    if (!measure)
+        writeCharsToOutput(cli, literal, (size_t) (format - literal));
 }
 
-static void onControlInput(EmbeddedCli *cli, char c) {
+static void processPrintQueue(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
+    PrintQueue *queue = &impl->printQueue;
 
-    // process \r\n and \n\r as single \r\n command
-    if ((impl->lastChar == '\r' && c == '\n') ||
-        (impl->lastChar == '\n' && c == '\r'))
+    if (queue->messages == NULL)
         return;
 
-    if (c == '\r' || c == '\n') {
-        // try to autocomplete command and then process it
-        onAutocompleteRequest(cli);
-
-        writeToOutput(cli, lineBreak);
+    embeddedCliBeginPrintBatch(cli);
+    // at most one full queue is printed, so producers can't stall processing
+    for (uint16_t i = 0; i <= queue->mask; ++i) {
+        uint16_t pos = queue->dequeuePos;
+        uint16_t index = (uint16_t) (pos & queue->mask);
+        if (CLI_ATOMIC_LOAD(&queue->sequences[index]) != (uint16_t) (pos + 1))
+            break;
 
-        if (impl->cmdSize > 0)
-            parseCommand(cli);
-        impl->cmdSize = 0;
-        impl->cmdBuffer[impl->cmdSize] = '\0';
-        impl->inputLineLength = 0;
-        impl->history.current = 0;
-        impl->cursorPos = 0;
+        beginPrint(cli);
+        writeToOutput(cli, &queue->messages[index * queue->messageSize]);
+        endPrint(cli);
 
-        writeToOutput(cli, impl->invitation);
-    } else if ((c == '\b' || c == 0x7F) && ((impl->cmdSize - impl->cursorPos) > 0)) {
-        // remove char from screen
-        writeToOutput(cli, escSeqCursorLeft); // Move cursor to left
-        writeToOutput(cli, escSeqDeleteChar); // And remove character
-        // and from buffer
-        size_t insertPos = strlen(impl->cmdBuffer) - impl->cursorPos;
-        memmove(&impl->cmdBuffer[insertPos - 1], &impl->cmdBuffer[insertPos], impl->cursorPos + 1);
-        --impl->cmdSize;
-    } else if (c == '\t') {
-        onAutocompleteRequest(cli);
+        // release slot for producers of the next round
+        CLI_ATOMIC_STORE(&queue->sequences[index], (uint16_t) (pos + queue->mask + 1));
+        queue->dequeuePos = (uint16_t) (pos + 1);
     }
-
+    embeddedCliEndPrintBatch(cli);
 }
 
-static void parseCommand(EmbeddedCli *cli) {
+static bool isPrintQueued(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
+    PrintQueue *queue = &impl->printQueue;
 
-    bool isEmpty = true;
+    if (queue->messages == NULL)
+        return false;
 
-    for (int i = 0; i < impl->cmdSize; ++i) {
-        if (impl->cmdBuffer[i] != ' ') {
-            isEmpty = false;
-            break;
-        }
-    }
-    // do not process empty commands
-    if (isEmpty)
-        return;
-    // push command to history before buffer is modified
-    historyPut(&impl->history, impl->cmdBuffer);
+    uint16_t pos = queue->dequeuePos;
+    uint16_t index = (uint16_t) (pos & queue->mask);
+    return CLI_ATOMIC_LOAD(&queue->sequences[index]) == (uint16_t) (pos + 1);
+}
 
-    char *cmdName = NULL;
-    char *cmdArgs = NULL;
-    bool nameFinished = false;
+static uint32_t getRequiredSize(EmbeddedCliConfig *config) {
+    uint32_t bindingCount = (uint32_t) config->maxBindingCount + cliInternalBindingCount;
+    uint32_t printQueueSize = getPrintQueueSize(config);
+    return (uint32_t) (CLI_UINT_SIZE * (
+            BYTES_TO_CLI_UINTS(sizeof(EmbeddedCli)) +
+            BYTES_TO_CLI_UINTS(sizeof(EmbeddedCliImpl)) +
+            BYTES_TO_CLI_UINTS(config->rxBufferSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->txBufferSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->cmdBufferSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->historyBufferSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(bindingCount * sizeof(CliCommandBinding)) +
+            BYTES_TO_CLI_UINTS(bindingCount * sizeof(uint8_t)) +
+            BYTES_TO_CLI_UINTS(config->logSourceCount * sizeof(LogSource)) +
+            BYTES_TO_CLI_UINTS(printQueueSize * sizeof(uint16_t)) +
+            BYTES_TO_CLI_UINTS(printQueueSize * config->printQueueMessageSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->statusLineCount * (config->statusLineLength + 1u) * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->scrollbackSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->tailBufferSize * sizeof(char)) +
+            BYTES_TO_CLI_UINTS(config->captureCommandSize * sizeof(char))));
+}
 
-    // find command name and command args inside command buffer
-    for (int i = 0; i < impl->cmdSize; ++i) {
-        char c = impl->cmdBuffer[i];
+static uint16_t getPrintQueueSize(EmbeddedCliConfig *config) {
+    if (config->printQueueMessageSize == 0)
+        return 0;
 
-        if (c == ' ') {
-            // all spaces between name and args are filled with zeros
-            // so name is a correct null-terminated string
-            if (cmdArgs == NULL)
-                impl->cmdBuffer[i] = '\0';
-            if (cmdName != NULL)
-                nameFinished = true;
+    // sequence numbers are compared as signed 16bit values, so size is limited
+    // (and queue of single slot can't tell full slot from empty one)
+    uint16_t size = 2;
+    while (size <= config->printQueueSize / 2 && size < 0x4000)
+        size = (uint16_t) (size * 2);
+    return config->printQueueSize > 0 ? size : 0;
+}
 
-        } else if (cmdName == NULL) {
-            cmdName = &impl->cmdBuffer[i];
-        } else if (cmdArgs == NULL && nameFinished) {
-            cmdArgs = &impl->cmdBuffer[i];
-        }
+#ifdef CLI_ATOMIC_FALLBACK
+static bool atomicCasFallback(uint16_t *ptr, uint16_t *expected, uint16_t desired) {
+#ifdef _MSC_VER
+    uint16_t current = (uint16_t) _InterlockedCompareExchange16(
+            (volatile short *) ptr, (short) desired, (short) *expected);
+    if (current != *expected) {
+        *expected = current;
+        return false;
     }
+    return true;
+#else
+    volatile uint16_t *value = ptr;
+    if (*value != *expected) {
+        *expected = *value;
+        return false;
+    }
+    *value = desired;
+    return true;
+#endif
+}
+#endif
 
-    // we keep two last bytes in cmd buffer reserved so cmdSize is always by 2
-    // less than cmdMaxSize
-    impl->cmdBuffer[impl->cmdSize + 1] = '\0';
+static void writeFormatted(EmbeddedCli *cli, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    formatToOutput(cli, format, args);
+    va_end(args);
+}
 
-    if (cmdName == NULL)
-        return;
+static void writePadding(EmbeddedCli *cli, char c, size_t count) {
+    const char *padding = c == '0' ? paddingZeros : (c == '-' ? paddingDashes : paddingSpaces);
+    size_t paddingLen = strlen(padding);
 
-    // try to find command in bindings
-    for (int i = 0; i < impl->bindingsCount; ++i) {
-        if (strcmp(cmdName, impl->bindings[i].name) == 0) {
-            if (impl->bindings[i].binding == NULL)
-                break;
+    while (count > 0) {
+        size_t len = count < paddingLen ? count : paddingLen;
+        writeCharsToOutput(cli, padding, len);
+        count -= len;
+    }
+}
 
-            if (impl->bindings[i].tokenizeArgs)
-                embeddedCliTokenizeArgs(cmdArgs);
-            // currently, output is blank line, so we can just print directly
-            SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
-            // check if help was requested (help is printed when no other options are set)
-            if (cmdArgs != NULL && (strcmp(cmdArgs, "-h") == 0 || strcmp(cmdArgs, "--help") == 0)) {
-                printBindingHelp(cli, &impl->bindings[i]);
-            } else {
-                impl->bindings[i].binding(cli, cmdArgs, impl->bindings[i].context);
-            }
-            UNSET_U8FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
-            return;
-        }
+static uint8_t formatUnsigned(char *buffer, unsigned long value, uint8_t base, bool upperCase) {
+    const char *digits = upperCase ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint8_t len = 0;
+
+    // digits are generated in reverse order
+    do {
+        buffer[len] = digits[value % base];
+        value /= base;
+        ++len;
+    } while (value > 0);
+
+    for (uint8_t i = 0; i < len / 2; ++i) {
+        char tmp = buffer[i];
+        buffer[i] = buffer[len - i - 1];
+        buffer[len - i - 1] = tmp;
     }
 
-    // command not found in bindings or binding was null
-    // try to call default callback
-    if (cli->onCommand != NULL) {
-        CliCommand command;
-        command.name = cmdName;
-        command.args = cmdArgs;
+    return len;
+}
 
-        // currently, output is blank line, so we can just print directly
-        SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
-        cli->onCommand(cli, &command);
-        UNSET_U8FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
-    } else {
-        onUnknownCommand(cli, cmdName);
+static uint8_t formatPointer(char *buffer, uintptr_t value) {
+    uint8_t len = 1;
+    for (uintptr_t rest = value >> 4; rest > 0; rest >>= 4)
+        ++len;
+
+    // digits are taken with shifts, so wide value is not divided
+    for (uint8_t i = len; i > 0; --i) {
+        buffer[i - 1] = "0123456789abcdef"[value & 0xFu];
+        value >>= 4;
     }
+    return len;
 }
 
 static void printBindingHelp(EmbeddedCli *cli, CliCommandBinding *binding) {
-    if (binding->help != NULL) {
-        cli->writeChar(cli, '\t');
-        writeToOutput(cli, binding->help);
-        writeToOutput(cli, lineBreak);
-    }
+    if (binding->help != NULL)
+        embeddedCliPrintf(cli, "\t%s", binding->help);
 }
 
 static void initInternalBindings(EmbeddedCli *cli) {
@@ -928,20 +4122,15 @@ static void onHelp(EmbeddedCli *cli, char *tokens, void *context) {
     UNUSED(context);
     PREPARE_IMPL(cli);
 
+    // output of help is printed line by line, so it can be filtered
     if (impl->bindingsCount == 0) {
-        writeToOutput(cli, "Help is not available");
-        writeToOutput(cli, lineBreak);
+        embeddedCliPrint(cli, "Help is not available");
         return;
     }
 
     uint16_t tokenCount = embeddedCliGetTokenCount(tokens);
     if (tokenCount == 0) {
-        for (int i = 0; i < impl->bindingsCount; ++i) {
-            writeToOutput(cli, " * ");
-            writeToOutput(cli, impl->bindings[i].name);
-            writeToOutput(cli, lineBreak);
-            printBindingHelp(cli, &impl->bindings[i]);
-        }
+        startListing(cli, PAGER_HELP, true);
     } else if (tokenCount == 1) {
         // try find command
         const char *helpStr = NULL;
@@ -955,29 +4144,144 @@ static void onHelp(EmbeddedCli *cli, char *tokens, void *context) {
             }
         }
         if (found && helpStr != NULL) {
-            writeToOutput(cli, " * ");
-            writeToOutput(cli, cmdName);
-            writeToOutput(cli, lineBreak);
-            cli->writeChar(cli, '\t');
-            writeToOutput(cli, helpStr);
-            writeToOutput(cli, lineBreak);
+            embeddedCliPrintf(cli, " * %s", cmdName);
+            embeddedCliPrintf(cli, "\t%s", helpStr);
         } else if (found) {
-            writeToOutput(cli, "Help is not available");
-            writeToOutput(cli, lineBreak);
+            embeddedCliPrint(cli, "Help is not available");
         } else {
             onUnknownCommand(cli, cmdName);
         }
     } else {
-        writeToOutput(cli, "Command \"help\" receives one or zero arguments");
-        writeToOutput(cli, lineBreak);
+        embeddedCliPrint(cli, "Command \"help\" receives one or zero arguments");
     }
 }
 
 static void onUnknownCommand(EmbeddedCli *cli, const char *name) {
-    writeToOutput(cli, "Unknown command: \"");
-    writeToOutput(cli, name);
-    writeToOutput(cli, "\". Write \"help\" for a list of available commands");
-    writeToOutput(cli, lineBreak);
+    embeddedCliPrintf(cli, "Unknown command: \"%s\". Write \"help\" for a list of available commands", name);
+}
+
+static void onLogLevel(EmbeddedCli *cli, char *tokens, void *context) {
+    UNUSED(context);
+
+    uint16_t tokenCount = embeddedCliGetTokenCount(tokens);
+    if (tokenCount == 0) {
+        printLogLevels(cli);
+        return;
+    }
+    if (tokenCount > 2) {
+        embeddedCliPrint(cli, "Command \"log-level\" receives up to two arguments");
+        return;
+    }
+
+    uint8_t source = CLI_LOG_SOURCE_ALL;
+    if (tokenCount == 2) {
+        const char *sourceName = embeddedCliGetToken(tokens, 1);
+        source = findLogSource(cli, sourceName);
+        if (source == CLI_LOG_SOURCE_ALL) {
+            embeddedCliPrintf(cli, "Unknown log source: \"%s\"", sourceName);
+            return;
+        }
+    }
+
+    const char *levelName = embeddedCliGetToken(tokens, tokenCount);
+    EmbeddedCliLogLevel level;
+    if (!parseLogLevel(levelName, &level)) {
+        embeddedCliPrintf(cli, "Unknown log level: \"%s\"", levelName);
+        return;
+    }
+
+    embeddedCliSetLogLevel(cli, source, level);
+    printLogLevels(cli);
+}
+
+static void printLogLevels(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    for (uint8_t i = 0; i < impl->logSourceCount; ++i) {
+        LogSource *source = &impl->logSources[i];
+        if (source->name != NULL)
+            embeddedCliPrintf(cli, " * %s: %s", source->name, logLevelNames[source->level]);
+        else
+            embeddedCliPrintf(cli, " * %u: %s", (unsigned int) i, logLevelNames[source->level]);
+    }
+    embeddedCliPrintf(cli, " * default: %s", logLevelNames[impl->logLevel]);
+}
+
+static uint8_t findLogSource(EmbeddedCli *cli, const char *name) {
+    PREPARE_IMPL(cli);
+
+    for (uint8_t i = 0; i < impl->logSourceCount; ++i) {
+        if (impl->logSources[i].name != NULL && strcmp(impl->logSources[i].name, name) == 0)
+            return i;
+    }
+
+    // sources without name can be selected by index
+    uint16_t index = 0;
+    const char *c = name;
+    while (*c >= '0' && *c <= '9' && index < impl->logSourceCount) {
+        index = (uint16_t) (index * 10 + (uint16_t) (*c - '0'));
+        ++c;
+    }
+    if (c != name && *c == '\0' && index < impl->logSourceCount)
+        return (uint8_t) index;
+
+    return CLI_LOG_SOURCE_ALL;
+}
+
+static bool parseLogLevel(const char *name, EmbeddedCliLogLevel *level) {
+    for (int i = CLI_LOG_NONE; i <= CLI_LOG_DEBUG; ++i) {
+        if (strcmp(logLevelNames[i], name) == 0) {
+            *level = (EmbeddedCliLogLevel) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool takeLogToken(EmbeddedCli *cli, LogSource *source) {
+    PREPARE_IMPL(cli);
+
+    if (impl->logRateLimit == 0 || cli->getTimeMs == NULL)
+        return true;
+
+    uint32_t now = cli->getTimeMs(cli);
+    uint32_t elapsed = now - source->lastRefillMs;
+
+    // time of full refill is not divided, it is less than 1 ms for high rates
+    if ((uint64_t) elapsed * impl->logRateLimit >= (uint64_t) impl->logBurst * 1000u) {
+        source->tokens = impl->logBurst;
+        source->lastRefillMs = now;
+    } else {
+        // elapsed * rate is less than burst * 1000 here, so there is no overflow
+        uint32_t added = elapsed * impl->logRateLimit / 1000u;
+        if (added > 0) {
+            uint32_t tokens = source->tokens + added;
+            source->tokens = (uint16_t) (tokens < impl->logBurst ? tokens : impl->logBurst);
+            // time is rounded up, so the same time is never counted twice
+            source->lastRefillMs += (added * 1000u + impl->logRateLimit - 1u) / impl->logRateLimit;
+        }
+    }
+
+    if (source->tokens == 0)
+        return false;
+
+    --source->tokens;
+    return true;
+}
+
+static void writeLogPrefix(EmbeddedCli *cli, EmbeddedCliLogLevel level, LogSource *source) {
+    PREPARE_IMPL(cli);
+
+    if (impl->logTimestamps && cli->getTimeMs != NULL) {
+        uint32_t now = cli->getTimeMs(cli);
+        writeFormatted(cli, "[%5lu.%03lu] ", (unsigned long) (now / 1000u), (unsigned long) (now % 1000u));
+    }
+    writeCharToOutput(cli, logLevelLetters[level]);
+    if (source != NULL && source->name != NULL) {
+        writeCharToOutput(cli, '/');
+        writeToOutput(cli, source->name);
+    }
+    writeToOutput(cli, ": ");
 }
 
 static AutocompletedCommand getAutocompletedCommand(EmbeddedCli *cli, const char *prefix) {
@@ -1031,44 +4335,83 @@ static AutocompletedCommand getAutocompletedCommand(EmbeddedCli *cli, const char
         }
     }
 
-    return cmd;
+    return cmd;
+}
+
+static AutocompletedCommand getCurrentAutocompletion(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED)) {
+        impl->autocompletion = getAutocompletedCommand(cli, impl->cmdBuffer);
+        SET_FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+    }
+    return impl->autocompletion;
 }
 
 static void printLiveAutocompletion(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
 
-    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_AUTOCOMPLETE_ENABLED))
+    // live autocompletion is not shown without escape sequences, since
+    // redraws would cost more than they save
+    if (!IS_FLAG_SET(impl->flags, CLI_FLAG_AUTOCOMPLETE_ENABLED) || !isEscSeqSupported(cli))
         return;
 
-    AutocompletedCommand cmd = getAutocompletedCommand(cli, impl->cmdBuffer);
+    AutocompletedCommand cmd = getCurrentAutocompletion(cli);
 
     if (cmd.candidateCount == 0) {
         cmd.autocompletedLen = impl->cmdSize;
     }
 
-    // save cursor location
-    writeToOutput(cli, escSeqCursorSave);
+    // find how many chars of autocompletion are already displayed
+    uint16_t displayedLen = impl->cmdSize;
+    if (impl->liveAutocompletion != NULL) {
+        while (displayedLen < cmd.autocompletedLen &&
+               displayedLen < impl->inputLineLength &&
+               impl->liveAutocompletion[displayedLen] == cmd.firstCandidate[displayedLen]) {
+            ++displayedLen;
+        }
+    }
+    if (displayedLen == cmd.autocompletedLen && displayedLen == impl->inputLineLength)
+        return;
 
-    moveCursor(cli, impl->cursorPos, CURSOR_DIRECTION_FORWARD);
+    // move cursor to the first char that is changed
+    uint16_t cursorMove = (uint16_t) (impl->cursorPos + displayedLen - impl->cmdSize);
+    bool partialRedraw = isPartialRedrawSupported(cli);
+    if (!partialRedraw)
+        writeToOutput(cli, escSeqCursorSave);
+    moveCursor(cli, cursorMove, CURSOR_DIRECTION_FORWARD);
 
     // print live autocompletion (or nothing, if it doesn't exist)
-    for (size_t i = impl->cmdSize; i < cmd.autocompletedLen; ++i) {
-        cli->writeChar(cli, cmd.firstCandidate[i]);
+    if (cmd.autocompletedLen > displayedLen) {
+        writeCharsToOutput(cli, &cmd.firstCandidate[displayedLen],
+                           cmd.autocompletedLen - displayedLen);
     }
-    // replace with spaces previous autocompletion
-    for (size_t i = cmd.autocompletedLen; i < impl->inputLineLength; ++i) {
-        cli->writeChar(cli, ' ');
+    // remove previous autocompletion
+    if (cmd.autocompletedLen < impl->inputLineLength) {
+        if (partialRedraw) {
+            writeToOutput(cli, escSeqEraseLine);
+        } else {
+            for (size_t i = cmd.autocompletedLen; i < impl->inputLineLength; ++i) {
+                writeCharToOutput(cli, ' ');
+            }
+        }
     }
     impl->inputLineLength = cmd.autocompletedLen;
+    impl->liveAutocompletion = cmd.firstCandidate;
 
     // restore cursor
-    writeToOutput(cli, escSeqCursorRestore);
+    if (partialRedraw) {
+        moveCursor(cli, (uint16_t) (cursorMove + cmd.autocompletedLen - displayedLen),
+                   CURSOR_DIRECTION_BACKWARD);
+    } else {
+        writeToOutput(cli, escSeqCursorRestore);
+    }
 }
 
-static void onAutocompleteRequest(EmbeddedCli *cli) {
+static void onAutocompleteRequest(EmbeddedCli *cli, bool allowPaging) {
     PREPARE_IMPL(cli);
 
-    AutocompletedCommand cmd = getAutocompletedCommand(cli, impl->cmdBuffer);
+    AutocompletedCommand cmd = getCurrentAutocompletion(cli);
 
     if (cmd.candidateCount == 0)
         return;
@@ -1083,6 +4426,7 @@ static void onAutocompleteRequest(EmbeddedCli *cli) {
         impl->cmdBuffer[cmd.autocompletedLen] = '\0';
 
         writeToOutput(cli, &impl->cmdBuffer[impl->cmdSize - impl->cursorPos]);
+        UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
         impl->cmdSize = cmd.autocompletedLen;
         impl->inputLineLength = impl->cmdSize;
         impl->cursorPos = 0; // Cursor has been moved to the end
@@ -1094,44 +4438,491 @@ static void onAutocompleteRequest(EmbeddedCli *cli) {
     // we need to completely clear current line since it begins with invitation
     clearCurrentLine(cli);
 
-    for (int i = 0; i < impl->bindingsCount; ++i) {
+    // input line is printed again when paused listing is finished
+    if (!startListing(cli, PAGER_CANDIDATES, allowPaging))
+        return;
+
+    writeToOutput(cli, impl->invitation);
+    writeToOutput(cli, impl->cmdBuffer);
+
+    impl->inputLineLength = impl->cmdSize;
+}
+
+static bool startListing(EmbeddedCli *cli, PagerContent content, bool allowPaging) {
+    PREPARE_IMPL(cli);
+
+    impl->pager.content = content;
+    impl->pager.waiting = false;
+    impl->pager.nextBinding = getNextListingBinding(cli, 0);
+    impl->pager.columns = 1;
+    impl->pager.columnWidth = 0;
+    impl->pager.pageLinesPrinted = 0;
+    impl->pager.pageLines = UINT16_MAX;
+
+    if (content == PAGER_CANDIDATES && impl->terminalWidth > 0) {
+        // all columns have the same width, so they are aligned
+        uint16_t maxLen = 0;
+        for (uint16_t i = impl->pager.nextBinding; i < impl->bindingsCount; i = getNextListingBinding(cli, i + 1)) {
+            uint16_t len = (uint16_t) strlen(impl->bindings[i].name);
+            if (len > maxLen)
+                maxLen = len;
+        }
+        impl->pager.columnWidth = (uint16_t) (maxLen + 2);
+        impl->pager.columns = (uint16_t) (impl->terminalWidth / impl->pager.columnWidth);
+        if (impl->pager.columns == 0)
+            impl->pager.columns = 1;
+    }
+
+    if (!allowPaging || IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING) ||
+        !embeddedCliStartGenerator(cli, listingGenerator, NULL)) {
+        while (listingGenerator(cli, NULL));
+        return true;
+    }
+
+    // last line of terminal is used for pager prompt, filtered output is
+    // not paged
+    if (impl->terminalHeight > 1 && impl->filter.type == FILTER_NONE)
+        impl->pager.pageLines = (uint16_t) (impl->terminalHeight - 1);
+    return false;
+}
+
+static bool listingGenerator(EmbeddedCli *cli, void *context) {
+    UNUSED(context);
+    PREPARE_IMPL(cli);
+    Pager *pager = &impl->pager;
+
+    if (pager->nextBinding >= impl->bindingsCount) {
+        pager->content = PAGER_NONE;
+        return false;
+    }
+
+    uint16_t itemLines = getListingItemLines(cli, pager->nextBinding);
+    // item that is longer than page is still printed on new page
+    if (pager->pageLinesPrinted > 0 && pager->pageLinesPrinted + itemLines > pager->pageLines) {
+        writeToOutput(cli, pagerPrompt);
+        pager->waiting = true;
+        return true;
+    }
+
+    pager->nextBinding = printListingItem(cli, pager->nextBinding);
+    pager->pageLinesPrinted = (uint16_t) (pager->pageLinesPrinted + itemLines);
+
+    if (pager->nextBinding >= impl->bindingsCount) {
+        pager->content = PAGER_NONE;
+        return false;
+    }
+    return true;
+}
+
+static uint16_t printListingItem(EmbeddedCli *cli, uint16_t binding) {
+    PREPARE_IMPL(cli);
+
+    if (impl->pager.content == PAGER_HELP) {
+        embeddedCliPrintf(cli, " * %s", impl->bindings[binding].name);
+        printBindingHelp(cli, &impl->bindings[binding]);
+        return getNextListingBinding(cli, (uint16_t) (binding + 1));
+    }
+
+    // candidates are printed in columns, all except last one are padded
+    for (uint16_t column = 0; column < impl->pager.columns && binding < impl->bindingsCount; ++column) {
+        const char *name = impl->bindings[binding].name;
+        writeToOutput(cli, name);
+        binding = getNextListingBinding(cli, (uint16_t) (binding + 1));
+        if (column + 1 < impl->pager.columns && binding < impl->bindingsCount)
+            writePadding(cli, ' ', impl->pager.columnWidth - strlen(name));
+    }
+    writeToOutput(cli, lineBreak);
+    return binding;
+}
+
+static uint16_t getListingItemLines(EmbeddedCli *cli, uint16_t binding) {
+    PREPARE_IMPL(cli);
+
+    if (impl->pager.content != PAGER_HELP)
+        return 1;
+
+    const char *help = impl->bindings[binding].help;
+    if (help == NULL)
+        return 1;
+
+    uint16_t lines = 2;
+    for (const char *c = help; *c != '\0'; ++c) {
+        if (*c == '\n')
+            ++lines;
+    }
+    return lines;
+}
+
+static uint16_t getNextListingBinding(EmbeddedCli *cli, uint16_t binding) {
+    PREPARE_IMPL(cli);
+
+    if (impl->pager.content == PAGER_CANDIDATES) {
         // autocomplete flag is set for all candidates by last call to
         // getAutocompletedCommand
-        if (!(impl->bindingsFlags[i] & BINDING_FLAG_AUTOCOMPLETE))
-            continue;
+        while (binding < impl->bindingsCount && !(impl->bindingsFlags[binding] & BINDING_FLAG_AUTOCOMPLETE))
+            ++binding;
+    }
+    return binding;
+}
 
-        const char *name = impl->bindings[i].name;
+static void onPagerInput(EmbeddedCli *cli, char c) {
+    PREPARE_IMPL(cli);
 
-        writeToOutput(cli, name);
-        writeToOutput(cli, lineBreak);
+    // \n after \r is part of the same key press (or the one that started listing)
+    if (impl->lastChar == '\r' && c == '\n')
+        return;
+
+    if (c == ' ') {
+        impl->pager.pageLines = (uint16_t) (impl->terminalHeight > 1 ? impl->terminalHeight - 1 : 1);
+    } else if (c == '\r' || c == '\n') {
+        impl->pager.pageLines = 1;
+    } else if (c == 'q' || c == 'Q') {
+        // listing is finished during next generator run
+        impl->pager.nextBinding = impl->bindingsCount;
+    } else {
+        return;
     }
 
-    writeToOutput(cli, impl->invitation);
-    writeToOutput(cli, impl->cmdBuffer);
+    erasePagerPrompt(cli);
+    impl->pager.waiting = false;
+    impl->pager.pageLinesPrinted = 0;
+}
 
-    impl->inputLineLength = impl->cmdSize;
+static void runGenerator(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    if (impl->generator == NULL || impl->pager.waiting)
+        return;
+
+    bool useBudget = impl->generatorBudgetMs > 0 && cli->getTimeMs != NULL;
+    uint32_t startMs = useBudget ? cli->getTimeMs(cli) : 0;
+    bool active = true;
+
+    // output of generator is printed the same way as output of command
+    SET_FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+    while (active && !impl->pager.waiting) {
+        if (isTxDrainedExternally(cli)) {
+            uint16_t capacity = (uint16_t) (impl->txBuffer.size - 1);
+            uint16_t freeSpace = (uint16_t) (capacity - fifoBufAvailable(&impl->txBuffer));
+            // chunk that is larger than whole buffer is written into empty buffer
+            uint16_t required = impl->generatorMaxChunk < capacity ? impl->generatorMaxChunk : capacity;
+            if (freeSpace == 0 || freeSpace < required)
+                break;
+        }
+
+        uint16_t countBefore = impl->outputCount;
+        active = impl->generator(cli, impl->generatorContext);
+        uint16_t chunk = (uint16_t) (impl->outputCount - countBefore);
+        if (chunk > impl->generatorMaxChunk)
+            impl->generatorMaxChunk = chunk;
+
+        if (useBudget && cli->getTimeMs(cli) - startMs >= impl->generatorBudgetMs)
+            break;
+    }
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_DIRECT_PRINT);
+
+    if (!active) {
+        impl->generator = NULL;
+        impl->generatorContext = NULL;
+        finishFilter(cli);
+        finishProgress(cli);
+        writeToOutput(cli, impl->invitation);
+        writeToOutput(cli, impl->cmdBuffer);
+        impl->inputLineLength = impl->cmdSize;
+        impl->cursorPos = 0;
+        printLiveAutocompletion(cli);
+    }
+}
+
+static void erasePagerPrompt(EmbeddedCli *cli) {
+    writeCharToOutput(cli, '\r');
+    if (isPartialRedrawSupported(cli)) {
+        writeToOutput(cli, escSeqEraseLine);
+    } else {
+        writePadding(cli, ' ', strlen(pagerPrompt));
+        writeCharToOutput(cli, '\r');
+    }
 }
 
 static void clearCurrentLine(EmbeddedCli *cli) {
     PREPARE_IMPL(cli);
-    size_t len = impl->inputLineLength + strlen(impl->invitation);
 
-    cli->writeChar(cli, '\r');
-    for (size_t i = 0; i < len; ++i) {
-        cli->writeChar(cli, ' ');
+    writeCharToOutput(cli, '\r');
+    if (isPartialRedrawSupported(cli)) {
+        writeToOutput(cli, escSeqEraseLine);
+    } else {
+        size_t len = impl->inputLineLength + strlen(impl->invitation);
+        for (size_t i = 0; i < len; ++i) {
+            writeCharToOutput(cli, ' ');
+        }
+        writeCharToOutput(cli, '\r');
     }
-    cli->writeChar(cli, '\r');
     impl->inputLineLength = 0;
 
     impl->cursorPos = 0;
 }
 
+static void replaceCommand(EmbeddedCli *cli, const char *text) {
+    PREPARE_IMPL(cli);
+    uint16_t len = (uint16_t) strlen(text);
+
+    if (isPartialRedrawSupported(cli) || !isEscSeqSupported(cli)) {
+        // keep on screen the part that is common for old and new command
+        uint16_t common = 0;
+        while (common < impl->cmdSize && common < len &&
+               impl->cmdBuffer[common] == text[common]) {
+            ++common;
+        }
+        uint16_t cursor = (uint16_t) (impl->cmdSize - impl->cursorPos);
+        if (cursor > common) {
+            moveCursor(cli, (uint16_t) (cursor - common), CURSOR_DIRECTION_BACKWARD);
+            cursor = common;
+        }
+        // chars between cursor and common part are written again to move
+        // cursor forward, it is shorter than escape sequence in most cases
+        writeCharsToOutput(cli, &text[cursor], (size_t) (len - cursor));
+        if (impl->inputLineLength > len) {
+            if (isEscSeqSupported(cli)) {
+                writeToOutput(cli, escSeqEraseLine);
+            } else {
+                uint16_t extra = (uint16_t) (impl->inputLineLength - len);
+                writePadding(cli, ' ', extra);
+                moveCursor(cli, extra, CURSOR_DIRECTION_BACKWARD);
+            }
+        }
+
+        memcpy(impl->cmdBuffer, text, len);
+        impl->cmdBuffer[len] = '\0';
+    } else {
+        clearCurrentLine(cli);
+        writeToOutput(cli, impl->invitation);
+
+        memcpy(impl->cmdBuffer, text, len);
+        impl->cmdBuffer[len] = '\0';
+        writeToOutput(cli, impl->cmdBuffer);
+    }
+
+    impl->cmdSize = len;
+    impl->inputLineLength = len;
+    impl->cursorPos = 0;
+    UNSET_U16FLAG(impl->flags, CLI_FLAG_AUTOCOMPLETE_CACHED);
+}
+
+static bool isPartialRedrawSupported(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    return impl->dialect == CLI_DIALECT_VT100;
+}
+
+static bool isEscSeqSupported(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    return impl->dialect != CLI_DIALECT_DUMB;
+}
+
 static void writeToOutput(EmbeddedCli *cli, const char *str) {
-    size_t len = strlen(str);
+    writeCharsToOutput(cli, str, strlen(str));
+}
+
+static void writeCharsToOutput(EmbeddedCli *cli, const char *buf, size_t len) {
+    PREPARE_IMPL(cli);
+
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_MATCHING)) {
+        matchChars(&impl->filter, buf, len);
+        return;
+    }
+
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_FILTERING)) {
+        filterOutput(cli, buf, len);
+        return;
+    }
+
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_RECORDING))
+        scrollbackAppend(&impl->scrollback, buf, len);
+
+    if (IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING)) {
+        captureChars(cli, buf, len);
+        return;
+    }
+
+    impl->outputCount = (uint16_t) (impl->outputCount + len);
+
+    if (isTxDrainedExternally(cli)) {
+        queueOutput(cli, buf, len);
+        return;
+    }
+
+    // while output is paused, it is kept in tx buffer (it always exists
+    // with XON/XOFF) and tx policy is applied when it doesn't fit
+    if (CLI_ATOMIC_LOAD_RELAXED(&impl->txPaused) != 0) {
+        queueOutput(cli, buf, len);
+        return;
+    }
+
+    if (impl->txBuffer.size == 0 || impl->outputDepth == 0) {
+        // output that was kept during pause goes first
+        flushOutput(cli);
+        emitChars(cli, buf, len);
+        return;
+    }
+
+    while (len > 0) {
+        uint16_t chunk = len > UINT16_MAX ? UINT16_MAX : (uint16_t) len;
+        uint16_t pushed = fifoBufPushBuffer(&impl->txBuffer, buf, chunk);
+        buf += pushed;
+        len -= pushed;
+        if (len == 0)
+            break;
+
+        flushOutput(cli);
+        // output could be paused while it is written
+        if (CLI_ATOMIC_LOAD_RELAXED(&impl->txPaused) != 0) {
+            SET_FLAG(impl->flags, CLI_FLAG_TX_OVERFLOW);
+            break;
+        }
+    }
+}
 
+static void writeCharToOutput(EmbeddedCli *cli, char c) {
+#ifdef EMBEDDED_CLI_WRITE_CHAR
+    PREPARE_IMPL(cli);
+    if (impl->txBuffer.size == 0 && (impl->flags & CLI_FLAGS_OUTPUT_PROCESSED) == 0 &&
+        CLI_ATOMIC_LOAD_RELAXED(&impl->txPaused) == 0 && CLI_ATOMIC_LOAD_RELAXED(&impl->txControlChar) == 0) {
+        ++impl->outputCount;
+        EMBEDDED_CLI_WRITE_CHAR(c);
+        return;
+    }
+#endif
+    writeCharsToOutput(cli, &c, 1);
+}
+
+static void emitChars(EmbeddedCli *cli, const char *buf, size_t len) {
+    if (len == 0)
+        return;
+
+#if defined(EMBEDDED_CLI_WRITE_CHARS)
+    UNUSED(cli);
+    EMBEDDED_CLI_WRITE_CHARS(buf, len);
+#elif defined(EMBEDDED_CLI_WRITE_CHAR)
+    UNUSED(cli);
     for (size_t i = 0; i < len; ++i) {
-        cli->writeChar(cli, str[i]);
+        EMBEDDED_CLI_WRITE_CHAR(buf[i]);
+    }
+#else
+    if (cli->writeChars != NULL) {
+        cli->writeChars(cli, buf, len);
+    } else if (cli->writeChar != NULL) {
+        for (size_t i = 0; i < len; ++i) {
+            cli->writeChar(cli, buf[i]);
+        }
+    }
+#endif
+}
+
+static void flushOutput(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+    if (isTxDrainedExternally(cli)) {
+        // application will drain it, just notify that there is new output
+        if ((fifoBufAvailable(&impl->txBuffer) > 0 || CLI_ATOMIC_LOAD_RELAXED(&impl->txControlChar) != 0) &&
+            cli->onTxAvailable != NULL)
+            cli->onTxAvailable(cli);
+        return;
+    }
+
+    // flow control char goes before any other output
+    uint16_t controlChar = CLI_ATOMIC_LOAD(&impl->txControlChar);
+    while (controlChar != 0) {
+        if (CLI_ATOMIC_CAS(&impl->txControlChar, &controlChar, 0)) {
+            char c = (char) controlChar;
+            emitChars(cli, &c, 1);
+            break;
+        }
+    }
+
+    if (impl->txBuffer.size == 0)
+        return;
+
+    // output is kept until XON is received
+    if (CLI_ATOMIC_LOAD_RELAXED(&impl->txPaused) != 0)
+        return;
+
+    const char *data;
+    uint16_t len;
+    while ((len = fifoBufPeek(&impl->txBuffer, &data)) > 0) {
+        emitChars(cli, data, len);
+        fifoBufConsume(&impl->txBuffer, len);
+    }
+}
+
+static void queueOutput(EmbeddedCli *cli, const char *buf, size_t len) {
+    PREPARE_IMPL(cli);
+    FifoBuf *txBuffer = &impl->txBuffer;
+
+    // with report and block policies rest of transaction is discarded after
+    // overflow, so there are no gaps in the middle of output
+    if (impl->txPolicy != CLI_TX_POLICY_DROP && IS_FLAG_SET(impl->flags, CLI_FLAG_TX_OVERFLOW))
+        return;
+
+    // partial chunk could cut escape sequence in half, so chunk that doesn't
+    // fit is discarded as a whole (unless cli can wait for free space, which
+    // is pointless while output is paused and impossible without clock)
+    bool canWait = impl->txPolicy == CLI_TX_POLICY_BLOCK && cli->getTimeMs != NULL &&
+                   CLI_ATOMIC_LOAD_RELAXED(&impl->txPaused) == 0;
+    uint16_t capacity = (uint16_t) (txBuffer->size - 1);
+    if (len > (size_t) (capacity - fifoBufAvailable(txBuffer)) && !canWait) {
+        SET_FLAG(impl->flags, CLI_FLAG_TX_OVERFLOW);
+        return;
+    }
+
+    while (len > 0) {
+        // chunk is pushed only when it fits as a whole, only chunks that are
+        // longer than whole buffer are split
+        uint16_t chunk = len > capacity ? capacity : (uint16_t) len;
+        if (chunk > capacity - fifoBufAvailable(txBuffer) && !waitTxSpace(cli, chunk)) {
+            SET_FLAG(impl->flags, CLI_FLAG_TX_OVERFLOW);
+            return;
+        }
+        fifoBufPushBuffer(txBuffer, buf, chunk);
+        buf += chunk;
+        len -= chunk;
+    }
+}
+
+static bool waitTxSpace(EmbeddedCli *cli, uint16_t required) {
+    PREPARE_IMPL(cli);
+    FifoBuf *txBuffer = &impl->txBuffer;
+
+    // make sure transfer is running and wait until enough chars are consumed
+    // (front is changed from ISR or other thread)
+    if (cli->onTxAvailable != NULL)
+        cli->onTxAvailable(cli);
+
+    uint16_t capacity = (uint16_t) (txBuffer->size - 1);
+    uint32_t startMs = cli->getTimeMs(cli);
+    while (capacity - fifoBufAvailable(txBuffer) < required) {
+        if (cli->getTimeMs(cli) - startMs >= CLI_TX_BLOCK_TIMEOUT_MS)
+            return false;
     }
+    return true;
+}
+
+static bool isTxDrainedExternally(EmbeddedCli *cli) {
+#ifdef CLI_STATIC_OUTPUT
+    UNUSED(cli);
+    return false;
+#else
+    PREPARE_IMPL(cli);
+    return impl->txBuffer.size > 0 && cli->writeChar == NULL && cli->writeChars == NULL;
+#endif
+}
+
+static bool isOutputAvailable(EmbeddedCli *cli) {
+#ifdef CLI_STATIC_OUTPUT
+    UNUSED(cli);
+    return true;
+#else
+    PREPARE_IMPL(cli);
+    return cli->writeChar != NULL || cli->writeChars != NULL || impl->txBuffer.size > 0 ||
+           IS_FLAG_SET(impl->flags, CLI_FLAG_CAPTURING);
+#endif
 }
 
 static void moveCursor(EmbeddedCli* cli, uint16_t count, bool direction) {
@@ -1139,47 +4930,171 @@ static void moveCursor(EmbeddedCli* cli, uint16_t count, bool direction) {
     if (count == 0)
         return;
 
-    // 5 = uint16_t max, 3 = escape sequence, 1 = string termination
-    char escBuffer[5 + 3 + 1] = { 0 };
-    char dirChar = direction ? escSeqCursorRight[2] : escSeqCursorLeft[2];
-    sprintf(escBuffer, "\x1B[%u%c", count, dirChar);
-    writeToOutput(cli, escBuffer);
+    // escape sequence takes at least 4 chars, so use backspaces when shorter
+    // (or when escape sequences are not supported at all)
+    if (direction == CURSOR_DIRECTION_BACKWARD &&
+        ((count < 4 && isPartialRedrawSupported(cli)) || !isEscSeqSupported(cli))) {
+        for (uint16_t i = 0; i < count; ++i) {
+            writeToOutput(cli, cursorLeftBackspace);
+        }
+        return;
+    }
+
+    writeCountedEscSeq(cli, direction ? escSeqCursorRight : escSeqCursorLeft, count);
 }
 
-static bool isControlChar(char c) {
-    return c == '\r' || c == '\n' || c == '\b' || c == '\t' || c == 0x7F;
+static void writeCountedEscSeq(EmbeddedCli *cli, const char *escSeq, uint16_t count) {
+    // 2 = escape sequence start, 1 = final char
+    char escBuffer[2 + CLI_NUMBER_BUFFER_SIZE + 1];
+    escBuffer[0] = escSeq[0];
+    escBuffer[1] = escSeq[1];
+    uint8_t len = formatUnsigned(&escBuffer[2], count, 10, false);
+    escBuffer[2 + len] = escSeq[2];
+    writeCharsToOutput(cli, escBuffer, (size_t) (len + 3));
 }
 
 static bool isDisplayableChar(char c) {
     return (c >= 32 && c <= 126);
 }
 
+static bool scanReceivedChars(EmbeddedCli *cli, const char *data, uint16_t len) {
+    PREPARE_IMPL(cli);
+
+    bool lineComplete = false;
+    for (uint16_t i = 0; i < len; ++i) {
+        char c = data[i];
+        if (c == '\r' || c == '\n') {
+            lineComplete = true;
+        } else if (impl->xonXoff && c == CLI_XOFF) {
+            CLI_ATOMIC_STORE(&impl->txPaused, 1);
+        } else if (impl->xonXoff && c == CLI_XON) {
+            // kept output is flushed by next processing
+            CLI_ATOMIC_STORE(&impl->txPaused, 0);
+        }
+    }
+    return lineComplete;
+}
+
+static void onCharsReceived(EmbeddedCli *cli, bool lineComplete) {
+    PREPARE_IMPL(cli);
+
+    if ((impl->xonXoff || cli->onRxThrottle != NULL) &&
+        fifoBufAvailable(&impl->rxBuffer) >= getRxHighWatermark(cli))
+        setRxThrottled(cli, true);
+
+    if (cli->onRxAvailable != NULL)
+        cli->onRxAvailable(cli, lineComplete);
+}
+
+static void setRxThrottled(EmbeddedCli *cli, bool throttled) {
+    PREPARE_IMPL(cli);
+
+    // state is set from receiving side and cleared by processing, so only
+    // one of them sends notification
+    uint16_t current = throttled ? 0 : 1;
+    while (!CLI_ATOMIC_CAS(&impl->rxThrottled, &current, (uint16_t) (throttled ? 1 : 0))) {
+        if (current == (throttled ? 1 : 0))
+            return;
+    }
+
+    // flow control char is sent by next flush (or tx peek) before other
+    // output, so nothing is written from receiving side
+    if (impl->xonXoff)
+        CLI_ATOMIC_STORE(&impl->txControlChar, (uint16_t) (throttled ? CLI_XOFF : CLI_XON));
+    if (cli->onRxThrottle != NULL)
+        cli->onRxThrottle(cli, throttled);
+}
+
+static uint16_t getRxHighWatermark(EmbeddedCli *cli) {
+    PREPARE_IMPL(cli);
+
+    if (impl->rxHighWatermark > 0)
+        return impl->rxHighWatermark;
+    return (uint16_t) (impl->rxBuffer.size / 4 * 3);
+}
+
+static void fifoBufInit(FifoBuf *buffer, uint16_t size) {
+    buffer->size = size;
+    buffer->mask = size > 0 && (size & (size - 1u)) == 0 ? (uint16_t) (size - 1u) : 0;
+    buffer->front = 0;
+    buffer->back = 0;
+}
+
+static uint16_t fifoBufWrap(FifoBuf *buffer, uint32_t pos) {
+    if (buffer->mask != 0)
+        return (uint16_t) (pos & buffer->mask);
+    return (uint16_t) (pos >= buffer->size ? pos - buffer->size : pos);
+}
+
 static uint16_t fifoBufAvailable(FifoBuf *buffer) {
-    if (buffer->back >= buffer->front)
-        return (uint16_t) (buffer->back - buffer->front);
+    uint16_t front = CLI_ATOMIC_LOAD(&buffer->front);
+    uint16_t back = CLI_ATOMIC_LOAD(&buffer->back);
+    if (back >= front)
+        return (uint16_t) (back - front);
     else
-        return (uint16_t) (buffer->size - buffer->front + buffer->back);
+        return (uint16_t) (buffer->size - front + back);
 }
 
 static char fifoBufPop(FifoBuf *buffer) {
     char a = '\0';
-    if (buffer->front != buffer->back) {
-        a = buffer->buf[buffer->front];
-        buffer->front = (uint16_t) (buffer->front + 1) % buffer->size;
+    uint16_t front = CLI_ATOMIC_LOAD_RELAXED(&buffer->front);
+    if (front != CLI_ATOMIC_LOAD(&buffer->back)) {
+        a = buffer->buf[front];
+        CLI_ATOMIC_STORE(&buffer->front, fifoBufWrap(buffer, front + 1u));
     }
     return a;
 }
 
 static bool fifoBufPush(FifoBuf *buffer, char a) {
-    uint16_t newBack = (uint16_t) (buffer->back + 1) % buffer->size;
-    if (newBack != buffer->front) {
-        buffer->buf[buffer->back] = a;
-        buffer->back = newBack;
+    // buffer without storage can't hold anything
+    if (buffer->size == 0)
+        return false;
+
+    uint16_t back = CLI_ATOMIC_LOAD_RELAXED(&buffer->back);
+    uint16_t newBack = fifoBufWrap(buffer, back + 1u);
+    if (newBack != CLI_ATOMIC_LOAD(&buffer->front)) {
+        buffer->buf[back] = a;
+        CLI_ATOMIC_STORE(&buffer->back, newBack);
         return true;
     }
     return false;
 }
 
+static uint16_t fifoBufPushBuffer(FifoBuf *buffer, const char *data, uint16_t len) {
+    if (buffer->size == 0)
+        return 0;
+
+    uint16_t back = CLI_ATOMIC_LOAD_RELAXED(&buffer->back);
+    // one element is always kept empty to distinguish full buffer from empty
+    uint16_t freeSpace = (uint16_t) (buffer->size - 1 - fifoBufAvailable(buffer));
+    if (len > freeSpace)
+        len = freeSpace;
+
+    uint16_t firstPart = (uint16_t) (buffer->size - back);
+    if (firstPart > len)
+        firstPart = len;
+
+    memcpy(&buffer->buf[back], data, firstPart);
+    memcpy(buffer->buf, &data[firstPart], (size_t) (len - firstPart));
+    CLI_ATOMIC_STORE(&buffer->back, fifoBufWrap(buffer, (uint32_t) back + len));
+    return len;
+}
+
+static uint16_t fifoBufPeek(FifoBuf *buffer, const char **data) {
+    uint16_t front = CLI_ATOMIC_LOAD_RELAXED(&buffer->front);
+    uint16_t back = CLI_ATOMIC_LOAD(&buffer->back);
+    *data = &buffer->buf[front];
+    if (back >= front)
+        return (uint16_t) (back - front);
+    else
+        return (uint16_t) (buffer->size - front);
+}
+
+static void fifoBufConsume(FifoBuf *buffer, uint16_t count) {
+    uint16_t front = CLI_ATOMIC_LOAD_RELAXED(&buffer->front);
+    CLI_ATOMIC_STORE(&buffer->front, fifoBufWrap(buffer, (uint32_t) front + count));
+}
+
 static bool historyPut(CliHistory *history, const char *str) {
     size_t len = strlen(str);
     // each item is ended with \0 so, need to have that much space at least
@@ -12,6 +12,16 @@ CliBuilder &CliBuilder::autocomplete(bool enabled) {
     return *this;
 }
 
+CliBuilder &CliBuilder::capture(uint16_t commandSize) {
+    this->config->captureCommandSize = commandSize;
+    return *this;
+}
+
+CliBuilder &CliBuilder::dialect(EmbeddedCliDialect dialect) {
+    this->config->dialect = dialect;
+    return *this;
+}
+
 CliWrapper CliBuilder::build() {
     std::optional<std::unique_ptr<CLI_UINT>> buffer = std::nullopt;
 
@@ -30,12 +40,93 @@ CliWrapper CliBuilder::build() {
     return {cli, std::move(buffer)};
 }
 
+CliBuilder &CliBuilder::generatorBudgetMs(uint16_t ms) {
+    this->config->generatorBudgetMs = ms;
+    return *this;
+}
+
 CliBuilder &CliBuilder::invitation(const char *text) {
     this->config->invitation = text;
     return *this;
 }
 
+CliBuilder &CliBuilder::logLevel(EmbeddedCliLogLevel level) {
+    this->config->logLevel = level;
+    return *this;
+}
+
+CliBuilder &CliBuilder::logRateLimit(uint16_t messagesPerSecond, uint16_t burst) {
+    this->config->logRateLimit = messagesPerSecond;
+    this->config->logBurst = burst;
+    return *this;
+}
+
+CliBuilder &CliBuilder::logSourceCount(uint8_t count) {
+    this->config->logSourceCount = count;
+    return *this;
+}
+
+CliBuilder &CliBuilder::logTimestamps(bool enabled) {
+    this->config->logTimestamps = enabled;
+    return *this;
+}
+
+CliBuilder &CliBuilder::printCoalesceMs(uint16_t ms) {
+    this->config->printCoalesceMs = ms;
+    return *this;
+}
+
+CliBuilder &CliBuilder::printQueue(uint16_t size, uint16_t messageSize) {
+    this->config->printQueueSize = size;
+    this->config->printQueueMessageSize = messageSize;
+    return *this;
+}
+
+CliBuilder &CliBuilder::rxBufferSize(uint16_t size) {
+    this->config->rxBufferSize = size;
+    return *this;
+}
+
+CliBuilder &CliBuilder::scrollback(uint16_t size) {
+    this->config->scrollbackSize = size;
+    return *this;
+}
+
 CliBuilder &CliBuilder::staticAllocation() {
     this->useStatic = true;
     return *this;
 }
+
+CliBuilder &CliBuilder::tailBuffer(uint16_t size) {
+    this->config->tailBufferSize = size;
+    return *this;
+}
+
+CliBuilder &CliBuilder::statusLines(uint8_t count, uint8_t length) {
+    this->config->statusLineCount = count;
+    this->config->statusLineLength = length;
+    return *this;
+}
+
+CliBuilder &CliBuilder::terminalSize(uint16_t width, uint16_t height) {
+    this->config->terminalWidth = width;
+    this->config->terminalHeight = height;
+    return *this;
+}
+
+CliBuilder &CliBuilder::txBufferSize(uint16_t size) {
+    this->config->txBufferSize = size;
+    return *this;
+}
+
+CliBuilder &CliBuilder::txPolicy(EmbeddedCliTxPolicy policy) {
+    this->config->txPolicy = policy;
+    return *this;
+}
+
+CliBuilder &CliBuilder::xonXoff(uint16_t highWatermark, uint16_t lowWatermark) {
+    this->config->xonXoff = true;
+    this->config->rxHighWatermark = highWatermark;
+    this->config->rxLowWatermark = lowWatermark;
+    return *this;
+}
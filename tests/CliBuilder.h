@@ -11,12 +11,46 @@ public:
 
     CliBuilder &autocomplete(bool enabled);
 
+    CliBuilder &dialect(EmbeddedCliDialect dialect);
+
     CliWrapper build();
 
+    CliBuilder &capture(uint16_t commandSize);
+
+    CliBuilder &generatorBudgetMs(uint16_t ms);
+
     CliBuilder &invitation(const char *text);
 
+    CliBuilder &logLevel(EmbeddedCliLogLevel level);
+
+    CliBuilder &logRateLimit(uint16_t messagesPerSecond, uint16_t burst);
+
+    CliBuilder &logSourceCount(uint8_t count);
+
+    CliBuilder &logTimestamps(bool enabled);
+
+    CliBuilder &printCoalesceMs(uint16_t ms);
+
+    CliBuilder &printQueue(uint16_t size, uint16_t messageSize);
+
+    CliBuilder &rxBufferSize(uint16_t size);
+
+    CliBuilder &scrollback(uint16_t size);
+
     CliBuilder &staticAllocation();
 
+    CliBuilder &statusLines(uint8_t count, uint8_t length);
+
+    CliBuilder &tailBuffer(uint16_t size);
+
+    CliBuilder &terminalSize(uint16_t width, uint16_t height);
+
+    CliBuilder &txBufferSize(uint16_t size);
+
+    CliBuilder &txPolicy(EmbeddedCliTxPolicy policy);
+
+    CliBuilder &xonXoff(uint16_t highWatermark, uint16_t lowWatermark);
+
 private:
     EmbeddedCliConfig *config;
     bool useStatic = false;
@@ -12,6 +12,16 @@
 
 static const std::string lineEnding = "\r\n";
 
+#ifdef CLI_TEST_STATIC_OUTPUT
+extern "C" void cliTestWriteChar(EmbeddedCli *cli, char c) {
+    ((CliWrapper *) cli->appContext)->writeOutput(&c, 1);
+}
+
+extern "C" void cliTestWriteChars(EmbeddedCli *cli, const char *buf, size_t len) {
+    ((CliWrapper *) cli->appContext)->writeOutput(buf, len);
+}
+#endif
+
 CliWrapper::CliWrapper(EmbeddedCli *cli, std::optional<std::unique_ptr<CLI_UINT>> buffer) {
     this->buffer = std::move(buffer);
     cli->appContext = this;
@@ -27,6 +37,7 @@ CliWrapper::CliWrapper(EmbeddedCli *cli, std::optional<std::unique_ptr<CLI_UINT>
     cli->writeChar = [](EmbeddedCli *embeddedCli, char c) {
         auto *wrapper = (CliWrapper *) embeddedCli->appContext;
         wrapper->txQueue.push_back(c);
+        ++wrapper->writeCallCount;
     };
     this->cli = cli;
 }
@@ -74,6 +85,42 @@ void CliWrapper::addBinding(const std::string &name,
     }
 }
 
+void CliWrapper::enableWriteChars() {
+    cli->writeChars = [](EmbeddedCli *embeddedCli, const char *buf, size_t len) {
+        auto *wrapper = (CliWrapper *) embeddedCli->appContext;
+        wrapper->txQueue.insert(wrapper->txQueue.end(), buf, buf + len);
+        ++wrapper->writeCallCount;
+    };
+}
+
+void CliWrapper::writeOutput(const char *buf, size_t len) {
+    txQueue.insert(txQueue.end(), buf, buf + len);
+    ++writeCallCount;
+}
+
+void CliWrapper::disableWrite() {
+    cli->writeChar = nullptr;
+    cli->writeChars = nullptr;
+}
+
+size_t CliWrapper::drainTx(size_t maxChars) {
+    size_t total = 0;
+    const char *data;
+    uint16_t len;
+    while (total < maxChars && embeddedCliTxPeek(cli, &data, &len)) {
+        if (len > maxChars - total)
+            len = (uint16_t) (maxChars - total);
+        txQueue.insert(txQueue.end(), data, data + len);
+        embeddedCliTxConsume(cli, len);
+        total += len;
+    }
+    return total;
+}
+
+size_t CliWrapper::getWriteCallCount() const {
+    return writeCallCount;
+}
+
 std::vector<CliWrapper::Command> &CliWrapper::getCalledBindings() {
     return calledBindings;
 }
@@ -91,6 +138,10 @@ CliWrapper::Display CliWrapper::getDisplay() {
     // Variable for saving the cursor position
     size_t cursorPosSave = 0;
 
+    // absolute positioning (used for status lines) moves cursor out of
+    // modelled lines, such output is ignored until cursor is restored
+    bool outside = false;
+
     for (auto c: txQueue) {
         switch (charMode) {
         default:
@@ -101,10 +152,9 @@ CliWrapper::Display CliWrapper::getDisplay() {
                 escapeSequenceCount.clear();
             }
             else if (c == '\b') {
-                if (cursorPosition > 0 && (cursorPosition - 1) < line.size()) {
-                    line.erase(cursorPosition - 1, 1);
+                // backspace only moves cursor, chars are not removed
+                if (cursorPosition > 0)
                     --cursorPosition;
-                }
             }
             else if (c == '\r') {
                 cursorPosition = 0;
@@ -114,6 +164,9 @@ CliWrapper::Display CliWrapper::getDisplay() {
                 output.push_back(line);
                 line.clear();
             }
+            else if (outside) {
+                break;
+            }
             else {
                 if (line.size() > cursorPosition) {
                     line.erase(cursorPosition, 1);
@@ -134,6 +187,11 @@ CliWrapper::Display CliWrapper::getDisplay() {
                 escapeSequenceCount.push_back(c);
                 break;
             }
+            if (c == ';') {
+                // only count of the last parameter is used
+                escapeSequenceCount.clear();
+                break;
+            }
 
             if (c == 'C') {
                 if (escapeSequenceCount.empty())
@@ -152,12 +210,22 @@ CliWrapper::Display CliWrapper::getDisplay() {
             }
             else if (c == 'u') {
                 cursorPosition = cursorPosSave;
+                outside = false;
+            }
+            else if (c == 'H') {
+                outside = true;
             }
             else if (c == '@') {
                 line.insert(cursorPosition, 1, ' ');
             }
             else if (c == 'P') {
-                line.erase(cursorPosition, 1);
+                size_t count = escapeSequenceCount.empty() ? 1 : strtoul(escapeSequenceCount.c_str(), NULL, 10);
+                if (cursorPosition < line.size())
+                    line.erase(cursorPosition, count);
+            }
+            else if (c == 'K') {
+                if (cursorPosition < line.size())
+                    line.erase(cursorPosition);
             }
 
             // Return to normal mode
@@ -188,6 +256,14 @@ std::string CliWrapper::getRawOutput() {
     return output;
 }
 
+std::string CliWrapper::getOutputWithEscSeq() {
+    return std::string(txQueue.begin(), txQueue.end());
+}
+
+size_t CliWrapper::getOutputSize() const {
+    return txQueue.size();
+}
+
 std::vector<CliWrapper::Command> &CliWrapper::getReceivedCommands() {
     return receivedCommands;
 }
@@ -200,6 +276,14 @@ EmbeddedCli *CliWrapper::raw() {
     return cli;
 }
 
+void CliWrapper::setTime(uint32_t ms) {
+    timeMs = ms;
+    cli->getTimeMs = [](EmbeddedCli *embeddedCli) {
+        auto *wrapper = (CliWrapper *) embeddedCli->appContext;
+        return wrapper->timeMs;
+    };
+}
+
 void CliWrapper::send(const std::string &chars) {
     for (char c: chars) {
         embeddedCliReceiveChar(cli, c);
@@ -219,7 +303,7 @@ void CliWrapper::trimStr(std::string &str) {
 
 void CliWrapper::removeEscSeq(std::string& str) {
     // Regex to find and delete escape sequences. NOTE This might need to be updated in the future
-    std::regex escapeSeqRe("\\x1b\\[[0-9]*[ABCDEFGM78dsu@PXLMJK]");
+    std::regex escapeSeqRe("\\x1b\\[[0-9;]*[ABCDEFGHM78dsu@PXLMJKr]");
     str = regex_replace(str, escapeSeqRe, "");
 }
 
@@ -40,6 +40,37 @@ public:
                     const std::optional<std::string> &help = std::nullopt,
                     bool tokenizeArgs = true);
 
+    /**
+     * Use writeChars callback for output instead of writeChar
+     */
+    void enableWriteChars();
+
+    /**
+     * Disable writeChar and writeChars callbacks, so output is kept inside
+     * tx buffer until it is drained with drainTx
+     */
+    void disableWrite();
+
+    /**
+     * Move chars from cli tx buffer to output
+     * @param maxChars - maximum number of chars to move
+     * @return number of moved chars
+     */
+    size_t drainTx(size_t maxChars = SIZE_MAX);
+
+    /**
+     * @return number of calls to writeChar or writeChars made by cli
+     */
+    size_t getWriteCallCount() const;
+
+    /**
+     * Add chars written by cli to output. Is used when output is bound at
+     * compile time, so write callbacks are not called
+     * @param buf
+     * @param len
+     */
+    void writeOutput(const char *buf, size_t len);
+
     /**
      * Vector of all called bindings
      * @return
@@ -49,7 +80,7 @@ public:
     /**
      * Returns processed output as individual lines when it is treated
      * by terminal.
-     * \b removes last character
+     * \b moves cursor left by one character
      * \r returns to the beginning of line (without removing chars)
      * \n moves to new line
      * Spaces at the end of the line are removed
@@ -62,6 +93,16 @@ public:
      */
     std::string getRawOutput();
 
+    /**
+     * @return raw output of cli including escape sequences
+     */
+    std::string getOutputWithEscSeq();
+
+    /**
+     * @return total number of chars written by cli (including escape sequences)
+     */
+    size_t getOutputSize() const;
+
     /**
      * Vector of all received commands (from onCommand callback)
      * without called bindings
@@ -87,6 +128,12 @@ public:
      */
     EmbeddedCli *raw();
 
+    /**
+     * Set time that is returned to cli by getTimeMs callback
+     * @param ms
+     */
+    void setTime(uint32_t ms);
+
     /**
      * Send chars to cli
      * @param chars
@@ -128,6 +175,16 @@ private:
      */
     std::vector<char> txQueue;
 
+    /**
+     * Number of calls to output functions
+     */
+    size_t writeCallCount = 0;
+
+    /**
+     * Current time for getTimeMs callback
+     */
+    uint32_t timeMs = 0;
+
     /**
      * All bindings that are registered in cli
      */
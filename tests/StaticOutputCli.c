@@ -0,0 +1,18 @@
+/*
+ * Library is compiled with output bound at compile time, so code paths for
+ * EMBEDDED_CLI_WRITE_CHAR and EMBEDDED_CLI_WRITE_CHARS are tested.
+ * Macros are expanded where cli is in scope, so written chars are passed
+ * to CliWrapper of that cli.
+ */
+#include <stddef.h>
+
+typedef struct EmbeddedCli EmbeddedCli;
+
+void cliTestWriteChar(EmbeddedCli *cli, char c);
+
+void cliTestWriteChars(EmbeddedCli *cli, const char *buf, size_t len);
+
+#define EMBEDDED_CLI_WRITE_CHAR(c) cliTestWriteChar(cli, c)
+#define EMBEDDED_CLI_WRITE_CHARS(buf, len) cliTestWriteChars(cli, buf, len)
+
+#include "embedded_cli.c"
@@ -3,6 +3,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <cstring>
+#include <memory>
+
 
 TEST_CASE("CLI. Autocomplete enabled", "[cli]") {
     CliWrapper cli = CliBuilder().build();
@@ -195,6 +198,39 @@ TEST_CASE("CLI. Autocomplete enabled", "[cli]") {
         REQUIRE(displayed.cursorColumn == 3);
     }
 
+    SECTION("Live autocomplete is not printed again when it is unchanged") {
+        cli.send("g");
+        cli.process();
+
+        size_t outputSize = cli.getOutputSize();
+        cli.send("e");
+        cli.process();
+        INFO("Only typed char is printed over live autocompletion");
+        REQUIRE(cli.getOutputSize() - outputSize == 1);
+
+        outputSize = cli.getOutputSize();
+        cli.send("\x1B[D\x1B[C\x07");
+        cli.process();
+        INFO("Cursor moves and ignored chars don't print live autocompletion");
+        REQUIRE(cli.getOutputSize() - outputSize == 2);
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines.size() == 1);
+        REQUIRE(displayed.lines[0] == "> get");
+        REQUIRE(displayed.cursorColumn == 4);
+    }
+
+    SECTION("Live autocomplete is updated after binding is added") {
+        cli.send("x");
+        cli.process();
+        cli.addBinding("xyz");
+        cli.print("text");
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines.back() == "> xyz");
+        REQUIRE(displayed.cursorColumn == 3);
+    }
+
     SECTION("Submit command with live autocompletion submits full command") {
         cli.sendLine("s");
         cli.process();
@@ -205,6 +241,64 @@ TEST_CASE("CLI. Autocomplete enabled", "[cli]") {
     }
 }
 
+TEST_CASE("CLI. Paste", "[cli]") {
+    CliWrapper cli = CliBuilder().build();
+    cli.enableWriteChars();
+
+    cli.addBinding("get");
+    cli.addBinding("get-new");
+    cli.addBinding("reset-first");
+    cli.process();
+    size_t writeCalls = cli.getWriteCallCount();
+    size_t outputSize = cli.getOutputSize();
+
+    SECTION("Pasted text is echoed with single write") {
+        cli.send("reset-f");
+        cli.process();
+
+        // echo, live autocompletion and cursor return
+        REQUIRE(cli.getWriteCallCount() == writeCalls + 3);
+        REQUIRE(cli.getOutputSize() - outputSize < 20);
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> reset-first");
+        REQUIRE(displayed.cursorColumn == 9);
+    }
+
+    SECTION("Pasted text is inserted in the middle of command") {
+        cli.send("gt");
+        cli.process();
+        cli.send("\x1B[De-n");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> ge-nt");
+        REQUIRE(displayed.cursorColumn == 6);
+    }
+
+    SECTION("Bracketed paste executes lines without autocompletion") {
+        cli.send("\x1B[200~get-n\r\nget\tled\r\x1B[201~");
+        cli.process();
+
+        auto &commands = cli.getReceivedCommands();
+        REQUIRE(commands.size() == 1);
+        REQUIRE(commands[0].name == "get-n");
+        REQUIRE(cli.getCalledBindings().size() == 1);
+        REQUIRE(cli.getCalledBindings()[0].name == "get");
+        REQUIRE(cli.getCalledBindings()[0].args[0] == "led");
+    }
+
+    SECTION("Autocompletion is shown when bracketed paste is finished") {
+        cli.send("\x1B[200~res");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines[0] == "> res");
+
+        cli.send("\x1B[201~");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines[0] == "> reset-first");
+    }
+}
+
 TEST_CASE("CLI. Autocomplete disabled", "[cli]") {
     CliWrapper cli = CliBuilder()
             .autocomplete(false)
@@ -231,4 +325,91 @@ TEST_CASE("CLI. Autocomplete disabled", "[cli]") {
         REQUIRE(displayed.lines[0] == "> set");
         REQUIRE(displayed.cursorColumn == 6);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("CLI. Autocomplete on dumb terminal", "[cli]") {
+    CliWrapper cli = CliBuilder().dialect(CLI_DIALECT_DUMB).build();
+
+    SECTION("Typing after autocompleted command") {
+        // name is allocated exactly, so reading past it is detected by ASAN
+        auto name = std::make_unique<char[]>(4);
+        memcpy(name.get(), "get", 4);
+        embeddedCliAddBinding(cli.raw(), {name.get(), nullptr, false, nullptr, nullptr});
+
+        for (char c : std::string("g\tet abcdefgh")) {
+            cli.send(std::string(1, c));
+            cli.process();
+        }
+
+        REQUIRE(cli.getDisplay().lines.back() == "> get et abcdefgh");
+    }
+}
+
+TEST_CASE("CLI. Autocomplete candidates layout", "[cli]") {
+    SECTION("Candidates are printed in columns") {
+        CliWrapper cli = CliBuilder().terminalSize(20, 0).build();
+        cli.addBinding("get-a");
+        cli.addBinding("get-b");
+        cli.addBinding("get-ccc");
+        cli.addBinding("get-d");
+
+        cli.send("get\t");
+        cli.process();
+        cli.send("\t");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        // columns are 9 chars wide (longest name and 2 spaces)
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "get-a    get-b");
+        REQUIRE(displayed.lines[1] == "get-ccc  get-d");
+        REQUIRE(displayed.lines[2] == "> get-");
+    }
+
+    SECTION("Candidates are paged") {
+        CliWrapper cli = CliBuilder().terminalSize(0, 3).build();
+        cli.addBinding("get-a");
+        cli.addBinding("get-b");
+        cli.addBinding("get-c");
+
+        cli.send("get-\t");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[1] == "get-b");
+        REQUIRE(displayed.lines[2] == "--More--");
+
+        cli.send(" ");
+        cli.process();
+
+        displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 4);
+        REQUIRE(displayed.lines[2] == "get-c");
+        REQUIRE(displayed.lines[3] == "> get-");
+        REQUIRE(displayed.cursorColumn == 6);
+    }
+
+    SECTION("Terminal size is detected") {
+        CliWrapper cli = CliBuilder().build();
+        cli.addBinding("get-a");
+        cli.addBinding("get-b");
+        cli.process();
+
+        embeddedCliRequestTerminalSize(cli.raw());
+        REQUIRE(cli.getRawOutput().find("\x1B[6n") != std::string::npos);
+
+        // cursor position report
+        cli.send("\x1B[24;80R");
+        cli.send("get-\t");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 2);
+        REQUIRE(displayed.lines[0] == "get-a  get-b");
+        REQUIRE(displayed.lines[1] == "> get-");
+    }
+}
@@ -81,6 +81,39 @@ TEST_CASE("CLI. Base tests", "[cli]") {
         REQUIRE(commands.back().args[0] == "led 1 150");
     }
 
+    SECTION("Receiving buffer") {
+        std::string data = "set led 1\r\nset led 2\r\n";
+        REQUIRE(embeddedCliReceiveBuffer(cli.raw(), data.c_str(), (uint16_t) data.size()) == data.size());
+        cli.process();
+
+        REQUIRE(commands.size() == 2);
+        REQUIRE(commands[0].args[0] == "led 1");
+        REQUIRE(commands[1].args[0] == "led 2");
+    }
+
+    SECTION("Receiving buffer that wraps around") {
+        cli.send("set led");
+        cli.process();
+        std::string data = " 1" + std::string(40, ' ') + "\r\nset led 2\r\n";
+        REQUIRE(embeddedCliReceiveBuffer(cli.raw(), data.c_str(), (uint16_t) data.size()) == data.size());
+        cli.process();
+
+        REQUIRE(commands.size() == 2);
+        REQUIRE(commands[0].args[0].find("led 1") == 0);
+        REQUIRE(commands[1].args[0] == "led 2");
+    }
+
+    SECTION("Receiving buffer that doesn't fit") {
+        std::string data(100, 'a');
+        REQUIRE(embeddedCliReceiveBuffer(cli.raw(), data.c_str(), (uint16_t) data.size()) == 63);
+        cli.process();
+
+        cli.sendLine("set led 3");
+        cli.process();
+        REQUIRE(commands.size() == 1);
+        REQUIRE(commands.back().args[0] == "led 3");
+    }
+
     SECTION("Removing some chars") {
         cli.sendLine("s\bget led\b\b\bjack 1\b56\b");
         cli.process();
@@ -157,6 +190,55 @@ TEST_CASE("CLI. Base tests", "[cli]") {
         REQUIRE(displayed.cursorColumn == 7);
     }
 
+    SECTION("Home and End keys") {
+        cli.send("et led\x1B[Hg\x1B[F1\x1BOH\x1B[3~s\x1B[4~");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> set led1");
+        REQUIRE(displayed.cursorColumn == 10);
+    }
+
+    SECTION("Line editing shortcuts") {
+        cli.send("get led on\x01\x06\x06\x0B");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines[0] == "> ge");
+
+        cli.send("t led\x02\x02\x02\x15");
+        cli.process();
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> led");
+        REQUIRE(displayed.cursorColumn == 2);
+    }
+
+    SECTION("Word movements use single sequence") {
+        cli.send("get some long argument");
+        cli.process();
+        size_t outputSize = cli.getOutputSize();
+
+        cli.send("\x1B[1;5D");
+        cli.process();
+        REQUIRE(cli.getOutputSize() - outputSize == 4);
+        REQUIRE(cli.getDisplay().cursorColumn == 16);
+
+        cli.send("\x1B""b\x1B""b\x1B[1;5C");
+        cli.process();
+        REQUIRE(cli.getDisplay().cursorColumn == 10);
+    }
+
+    SECTION("Removing word before cursor") {
+        cli.send("get some long  \x17");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> get some");
+        REQUIRE(displayed.cursorColumn == 11);
+
+        cli.sendLine("\x17\x17led");
+        cli.process();
+        REQUIRE(commands.back().name == "led");
+    }
+
     SECTION("Command that is too long") {
         size_t cmdMax = embeddedCliDefaultConfig()->cmdBufferSize;
         std::string cmdMaxTest = std::string(cmdMax/2, 'x');
@@ -266,3 +348,71 @@ TEST_CASE("CLI. Changed invitation", "[cli]") {
     REQUIRE(display.lines[1] == "inv");
     REQUIRE(display.cursorColumn == 4);
 }
+
+TEST_CASE("CLI. Dumb dialect", "[cli]") {
+    CliWrapper cli = CliBuilder().dialect(CLI_DIALECT_DUMB).build();
+    cli.addBinding("get-led");
+
+    auto cmdLeft = "\x1B[D";
+
+    SECTION("Typing and erasing at the end of line") {
+        cli.send("get");
+        cli.process();
+        REQUIRE(cli.getOutputWithEscSeq() == "> get");
+
+        size_t outputSize = cli.getOutputSize();
+        cli.send("\b");
+        cli.process();
+        REQUIRE(cli.getOutputSize() - outputSize == 3);
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> ge");
+        REQUIRE(display.cursorColumn == 4);
+    }
+
+    SECTION("Editing in the middle of line") {
+        cli.send("gt");
+        cli.send(cmdLeft);
+        cli.send("e");
+        cli.process();
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> get");
+        REQUIRE(display.cursorColumn == 4);
+
+        cli.send("x");
+        cli.send("\b");
+        cli.process();
+
+        display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> get");
+        REQUIRE(display.cursorColumn == 4);
+        REQUIRE(cli.getOutputWithEscSeq().find('\x1B') == std::string::npos);
+    }
+
+    SECTION("Removing word in the middle of line") {
+        cli.send("get led on\x1B[D\x1B[D\x1B[D\x17");
+        cli.process();
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> get  on");
+        REQUIRE(display.cursorColumn == 6);
+        REQUIRE(cli.getOutputWithEscSeq().find('\x1B') == std::string::npos);
+    }
+
+    SECTION("Navigating history") {
+        cli.sendLine("set param");
+        cli.sendLine("set");
+        cli.send("\x1B[A\x1B[A");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines.back() == "> set param");
+
+        cli.send("\x1B[B");
+        cli.process();
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> set");
+        REQUIRE(display.cursorColumn == 5);
+        REQUIRE(cli.getOutputWithEscSeq().find('\x1B') == std::string::npos);
+    }
+}
@@ -0,0 +1,232 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+struct DumpCommand {
+    std::string args;
+};
+
+static void addDumpBinding(CliWrapper &cli, DumpCommand &command) {
+    embeddedCliAddBinding(cli.raw(), {
+            .name = "dump",
+            .help = nullptr,
+            .tokenizeArgs = false,
+            .context = &command,
+            .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                ((DumpCommand *) context)->args = args != nullptr ? args : "";
+                embeddedCliPrint(embeddedCli, "adc: ok");
+                embeddedCliPrintf(embeddedCli, "uart: %s", "rx timeout");
+                embeddedCliPrint(embeddedCli, "spi: ok");
+                embeddedCliPrintf(embeddedCli, "i2c: %s %d", "timeout", 3);
+                embeddedCliPrint(embeddedCli, "gpio: ok");
+            }
+    });
+}
+
+TEST_CASE("CLI. Output filters", "[cli]") {
+    CliWrapper cli = CliBuilder().scrollback(256).tailBuffer(64).build();
+    DumpCommand command;
+    addDumpBinding(cli, command);
+
+    SECTION("Command is executed without pipe suffix") {
+        cli.sendLine("dump \"a|b\" c | grep ok");
+        cli.process();
+
+        REQUIRE(command.args == "\"a|b\" c");
+    }
+
+    SECTION("Grep passes lines that contain substring") {
+        cli.sendLine("dump | grep timeout");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[0] == "> dump | grep timeout");
+        REQUIRE(lines[1] == "uart: rx timeout");
+        REQUIRE(lines[2] == "i2c: timeout 3");
+        REQUIRE(lines[3] == ">");
+    }
+
+    SECTION("Grep pattern with wildcard") {
+        cli.sendLine("dump | grep i*t*3");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "i2c: timeout 3");
+    }
+
+    SECTION("Grep pattern matches after partial match") {
+        embeddedCliAddBinding(cli.raw(), {
+                .name = "repeat",
+                .help = nullptr,
+                .tokenizeArgs = false,
+                .context = nullptr,
+                .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                    (void) args;
+                    (void) context;
+                    embeddedCliPrint(embeddedCli, "aabab");
+                    embeddedCliPrint(embeddedCli, "abaab");
+                }
+        });
+
+        cli.sendLine("repeat | grep abab");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "aabab");
+    }
+
+    SECTION("Head passes first lines") {
+        cli.sendLine("dump | head 2");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[1] == "adc: ok");
+        REQUIRE(lines[2] == "uart: rx timeout");
+    }
+
+    SECTION("Tail passes last lines") {
+        cli.sendLine("dump | tail 2");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[1] == "i2c: timeout 3");
+        REQUIRE(lines[2] == "gpio: ok");
+    }
+
+    SECTION("Tail doesn't require scrollback") {
+        CliWrapper tailOnly = CliBuilder().tailBuffer(64).build();
+        DumpCommand tailCommand;
+        addDumpBinding(tailOnly, tailCommand);
+
+        tailOnly.sendLine("dump | tail 1");
+        tailOnly.process();
+
+        auto lines = tailOnly.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "gpio: ok");
+    }
+
+    SECTION("Tail prints only lines that fit into tail buffer") {
+        CliWrapper tailOnly = CliBuilder().tailBuffer(24).build();
+        DumpCommand tailCommand;
+        addDumpBinding(tailOnly, tailCommand);
+
+        tailOnly.sendLine("dump | tail 3");
+        tailOnly.process();
+
+        auto lines = tailOnly.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "gpio: ok");
+    }
+
+    SECTION("Tail is not available without tail buffer") {
+        CliWrapper noTail = CliBuilder().scrollback(256).build();
+        DumpCommand noTailCommand;
+        addDumpBinding(noTail, noTailCommand);
+
+        noTail.sendLine("dump | tail 1");
+        noTail.process();
+
+        auto lines = noTail.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "Filter \"tail\" requires tail buffer");
+    }
+
+    SECTION("Filtered out lines are not recorded to scrollback") {
+        cli.sendLine("dump | tail 1");
+        cli.process();
+        cli.sendLine("dump | grep spi");
+        cli.process();
+        embeddedCliReplayScrollback(cli.raw(), 0);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 9);
+        REQUIRE(lines[4] == "> dump | tail 1");
+        REQUIRE(lines[5] == "gpio: ok");
+        REQUIRE(lines[6] == "> dump | grep spi");
+        REQUIRE(lines[7] == "spi: ok");
+    }
+
+    SECTION("Lines of multi-line prints are filtered separately") {
+        embeddedCliAddBinding(cli.raw(), {
+                .name = "multi",
+                .help = nullptr,
+                .tokenizeArgs = false,
+                .context = nullptr,
+                .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                    (void) args;
+                    (void) context;
+                    embeddedCliPrint(embeddedCli, "one\r\ntwo");
+                    embeddedCliPrint(embeddedCli, "three\r\nfour");
+                }
+        });
+
+        cli.sendLine("multi | count");
+        cli.process();
+        cli.sendLine("multi | head 3");
+        cli.process();
+        cli.sendLine("multi | tail 1");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 9);
+        REQUIRE(lines[1] == "4");
+        REQUIRE(lines[3] == "one");
+        REQUIRE(lines[4] == "two");
+        REQUIRE(lines[5] == "three");
+        REQUIRE(lines[6] == "> multi | tail 1");
+        REQUIRE(lines[7] == "four");
+    }
+
+    SECTION("Output of help is filtered") {
+        cli.sendLine("help | grep help");
+        cli.process();
+        cli.sendLine("help | count");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 5);
+        REQUIRE(lines[1] == " * help");
+        REQUIRE(lines[2] == "> help | count");
+        REQUIRE(lines[3] == "3");
+    }
+
+    SECTION("Count prints number of lines") {
+        cli.sendLine("dump | count");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "5");
+        REQUIRE(lines[2] == ">");
+    }
+
+    SECTION("Filter is removed after command") {
+        cli.sendLine("dump | head 1");
+        cli.process();
+        cli.print("async");
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[1] == "adc: ok");
+        REQUIRE(lines[2] == "async");
+    }
+
+    SECTION("Command with unknown filter is not executed") {
+        cli.sendLine("dump | sort");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 3);
+        REQUIRE(lines[1] == "Unknown filter: \"sort\"");
+        REQUIRE(command.args.empty());
+    }
+}
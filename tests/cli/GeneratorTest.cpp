@@ -0,0 +1,175 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+struct LinesGenerator {
+    CliWrapper *wrapper;
+    uint32_t timeMs = 0;
+    int printed = 0;
+    int total = 0;
+};
+
+static bool generateLine(EmbeddedCli *cli, void *context) {
+    auto *generator = (LinesGenerator *) context;
+    std::string line = "line " + std::to_string(generator->printed);
+    embeddedCliPrint(cli, line.c_str());
+    ++generator->printed;
+    // each chunk takes 1ms
+    generator->wrapper->setTime(++generator->timeMs);
+    return generator->printed < generator->total;
+}
+
+static void addLinesBinding(CliWrapper &cli, LinesGenerator &generator) {
+    embeddedCliAddBinding(cli.raw(), {
+            .name = "lines",
+            .help = nullptr,
+            .tokenizeArgs = false,
+            .context = &generator,
+            .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                (void) args;
+                embeddedCliStartGenerator(embeddedCli, generateLine, context);
+            }
+    });
+}
+
+TEST_CASE("CLI. Generators", "[cli]") {
+    SECTION("Generator without budget is finished in single process call") {
+        CliWrapper cli = CliBuilder().build();
+        LinesGenerator generator{&cli};
+        generator.total = 3;
+        addLinesBinding(cli, generator);
+
+        cli.sendLine("lines");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 5);
+        REQUIRE(lines[0] == "> lines");
+        REQUIRE(lines[1] == "line 0");
+        REQUIRE(lines[2] == "line 1");
+        REQUIRE(lines[3] == "line 2");
+        REQUIRE(lines[4] == ">");
+    }
+
+    SECTION("Generator is paused when time budget is exceeded") {
+        CliWrapper cli = CliBuilder().generatorBudgetMs(2).build();
+        cli.setTime(0);
+        LinesGenerator generator{&cli};
+        generator.total = 5;
+        addLinesBinding(cli, generator);
+
+        cli.sendLine("lines");
+        cli.process();
+        REQUIRE(generator.printed == 2);
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[2] == "line 1");
+        REQUIRE(lines[3].empty());
+
+        cli.process();
+        REQUIRE(generator.printed == 4);
+
+        cli.process();
+        REQUIRE(generator.printed == 5);
+        lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 7);
+        REQUIRE(lines[5] == "line 4");
+        REQUIRE(lines[6] == ">");
+    }
+
+    SECTION("Input is processed after generator is finished") {
+        CliWrapper cli = CliBuilder().generatorBudgetMs(1).build();
+        cli.setTime(0);
+        LinesGenerator generator{&cli};
+        generator.total = 3;
+        addLinesBinding(cli, generator);
+        cli.addBinding("get");
+
+        cli.sendLine("lines");
+        cli.process();
+        cli.sendLine("get");
+        cli.process();
+        REQUIRE(cli.getCalledBindings().empty());
+
+        cli.process();
+        REQUIRE(generator.printed == 3);
+        REQUIRE(cli.getCalledBindings().size() == 1);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 6);
+        REQUIRE(lines[3] == "line 2");
+        REQUIRE(lines[4] == "> get");
+        REQUIRE(lines[5] == ">");
+    }
+
+    SECTION("Generator waits for space in tx buffer") {
+        CliWrapper cli = CliBuilder().txBufferSize(32).build();
+        cli.disableWrite();
+        LinesGenerator generator{&cli};
+        generator.total = 10;
+        addLinesBinding(cli, generator);
+
+        cli.sendLine("lines");
+        cli.process();
+        REQUIRE(generator.printed > 0);
+        REQUIRE(generator.printed < generator.total);
+
+        for (int i = 0; i < 20 && generator.printed < generator.total; ++i) {
+            cli.drainTx();
+            cli.process();
+        }
+        cli.drainTx();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 12);
+        for (int i = 0; i < generator.total; ++i) {
+            REQUIRE(lines[i + 1] == "line " + std::to_string(i));
+        }
+        REQUIRE(lines[11] == ">");
+    }
+
+    SECTION("Step larger than tx buffer doesn't stop generator") {
+        CliWrapper cli = CliBuilder().txBufferSize(32).build();
+        cli.disableWrite();
+        LinesGenerator generator{&cli};
+        generator.total = 2;
+        embeddedCliAddBinding(cli.raw(), {
+                .name = "long",
+                .help = nullptr,
+                .tokenizeArgs = false,
+                .context = &generator,
+                .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                    (void) args;
+                    embeddedCliStartGenerator(embeddedCli, [](EmbeddedCli *c, void *ctx) {
+                        auto *g = (LinesGenerator *) ctx;
+                        embeddedCliPrint(c, std::string(40, 'x').c_str());
+                        return ++g->printed < g->total;
+                    }, context);
+                }
+        });
+        cli.addBinding("get");
+
+        cli.sendLine("long");
+        for (int i = 0; i < 10 && generator.printed < generator.total; ++i) {
+            cli.process();
+            cli.drainTx();
+        }
+        REQUIRE(generator.printed == generator.total);
+
+        cli.sendLine("get");
+        cli.process();
+        cli.drainTx();
+        REQUIRE(cli.getCalledBindings().size() == 1);
+    }
+
+    SECTION("Only one generator can be active") {
+        CliWrapper cli = CliBuilder().build();
+        LinesGenerator generator{&cli};
+
+        REQUIRE(embeddedCliStartGenerator(cli.raw(), generateLine, &generator));
+        REQUIRE(!embeddedCliStartGenerator(cli.raw(), generateLine, &generator));
+    }
+}
@@ -75,3 +75,62 @@ TEST_CASE("CLI. Help", "[cli]") {
         REQUIRE(displayed.cursorColumn == 2);
     }
 }
+
+TEST_CASE("CLI. Help with pager", "[cli]") {
+    // 4 lines for help and the last one for pager prompt
+    CliWrapper cli = CliBuilder().terminalSize(80, 5).build();
+    cli.addBinding("get", "Get specific parameter");
+    cli.addBinding("set", "Set specific parameter");
+    cli.addBinding("reset", "Reset specific parameter");
+
+    cli.sendLine("help");
+    cli.process();
+
+    SECTION("Only first page is printed") {
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 6);
+        REQUIRE(displayed.lines[1] == " * help");
+        REQUIRE(displayed.lines[3] == " * get");
+        REQUIRE(displayed.lines[5] == "--More--");
+        REQUIRE(cli.getRawOutput().find("set") == std::string::npos);
+    }
+
+    SECTION("Next page is printed after space") {
+        cli.send(" ");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 10);
+        REQUIRE(displayed.lines[5] == " * set");
+        REQUIRE(displayed.lines[7] == " * reset");
+        REQUIRE(displayed.lines[9] == ">");
+    }
+
+    SECTION("Next item is printed after enter") {
+        cli.send("\r");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 8);
+        REQUIRE(displayed.lines[5] == " * set");
+        REQUIRE(displayed.lines[7] == "--More--");
+    }
+
+    SECTION("Listing is stopped with q") {
+        cli.send("xq");
+        cli.process();
+        cli.process();
+        cli.send("x");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 6);
+        REQUIRE(displayed.lines[5] == "> x");
+        REQUIRE(cli.getRawOutput().find("reset") == std::string::npos);
+        REQUIRE(cli.getCalledBindings().empty());
+    }
+}
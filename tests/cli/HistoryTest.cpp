@@ -89,4 +89,58 @@ TEST_CASE("CLI. History", "[cli]") {
         cli.process();
         REQUIRE(cli.getDisplay().lines.back() == "> get param 2");
     }
+
+    SECTION("Only different part of command is written when navigating") {
+        CliWrapper plainCli = CliBuilder().autocomplete(false).build();
+        plainCli.sendLine("get param 1");
+        plainCli.sendLine("get param 2");
+        plainCli.send(cmdUp);
+        plainCli.process();
+        REQUIRE(plainCli.getDisplay().lines.back() == "> get param 2");
+
+        size_t outputSize = plainCli.getOutputSize();
+        plainCli.send(cmdUp);
+        plainCli.process();
+
+        auto displayed = plainCli.getDisplay();
+        REQUIRE(displayed.lines.back() == "> get param 1");
+        REQUIRE(displayed.cursorColumn == 13);
+        // backspace and new char
+        REQUIRE(plainCli.getOutputSize() - outputSize == 2);
+    }
+
+    SECTION("Longer command is erased when navigating to shorter one") {
+        cli.sendLine("get");
+        cli.sendLine("get param");
+        cli.send(cmdUp);
+        cli.send(cmdUp);
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines.back() == "> get");
+        REQUIRE(displayed.cursorColumn == 5);
+    }
+}
+
+TEST_CASE("CLI. History with basic dialect", "[cli]") {
+    CliWrapper cli = CliBuilder().dialect(CLI_DIALECT_VT100_BASIC).build();
+
+    auto cmdUp = "\x1B[A";
+    auto cmdDown = "\x1B[B";
+
+    SECTION("Navigate with full line redraw") {
+        cli.sendLine("get param 1");
+        cli.sendLine("get");
+        cli.send(cmdUp);
+        cli.send(cmdUp);
+        cli.process();
+        REQUIRE(cli.getDisplay().lines.back() == "> get param 1");
+
+        cli.send(cmdDown);
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines.back() == "> get");
+        REQUIRE(displayed.cursorColumn == 5);
+    }
 }
@@ -0,0 +1,159 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("CLI. Logging", "[cli]") {
+    SECTION("Messages above log level are rejected") {
+        CliWrapper cli = CliBuilder().logLevel(CLI_LOG_WARNING).build();
+        cli.process();
+
+        embeddedCliLog(cli.raw(), CLI_LOG_ERROR, 0, "error %d", 1);
+        embeddedCliLog(cli.raw(), CLI_LOG_WARNING, 0, "warning");
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "info");
+        embeddedCliLog(cli.raw(), CLI_LOG_DEBUG, 0, "debug");
+
+        REQUIRE(embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_WARNING, 0));
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_INFO, 0));
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "E: error 1");
+        REQUIRE(displayed.lines[1] == "W: warning");
+        REQUIRE(displayed.lines[2] == ">");
+    }
+
+    SECTION("Log message keeps current command") {
+        CliWrapper cli = CliBuilder().build();
+        cli.send("cmd");
+        cli.process();
+
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "info");
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 2);
+        REQUIRE(displayed.lines[0] == "I: info");
+        REQUIRE(displayed.lines[1] == "> cmd");
+        REQUIRE(displayed.cursorColumn == 5);
+    }
+
+    SECTION("Sources have individual names and levels") {
+        CliWrapper cli = CliBuilder().logSourceCount(2).build();
+        embeddedCliSetLogSourceName(cli.raw(), 0, "uart");
+        embeddedCliSetLogLevel(cli.raw(), 1, CLI_LOG_DEBUG);
+        cli.process();
+
+        embeddedCliLog(cli.raw(), CLI_LOG_DEBUG, 0, "hidden");
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "shown");
+        embeddedCliLog(cli.raw(), CLI_LOG_DEBUG, 1, "debug");
+        embeddedCliLog(cli.raw(), CLI_LOG_DEBUG, 5, "hidden");
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "I/uart: shown");
+        REQUIRE(displayed.lines[1] == "D: debug");
+    }
+
+    SECTION("Timestamps are printed when enabled") {
+        CliWrapper cli = CliBuilder().logTimestamps(true).build();
+        cli.setTime(12345);
+        cli.process();
+
+        embeddedCliLog(cli.raw(), CLI_LOG_ERROR, 0, "error");
+
+        REQUIRE(cli.getDisplay().lines[0] == "[   12.345] E: error");
+    }
+
+    SECTION("Messages above rate limit are dropped and counted") {
+        CliWrapper cli = CliBuilder().logSourceCount(1).logRateLimit(10, 2).build();
+        cli.setTime(1000);
+        cli.process();
+
+        for (int i = 0; i < 5; ++i) {
+            embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "msg %d", i);
+        }
+        cli.setTime(1100);
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "msg %d", 5);
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "msg %d", 6);
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 5);
+        REQUIRE(displayed.lines[0] == "I: msg 0");
+        REQUIRE(displayed.lines[1] == "I: msg 1");
+        REQUIRE(displayed.lines[2] == "W: 3 messages dropped");
+        REQUIRE(displayed.lines[3] == "I: msg 5");
+    }
+
+    SECTION("Burst is limited when rate is higher than burst per millisecond") {
+        CliWrapper cli = CliBuilder().logSourceCount(1).logRateLimit(10000, 2).build();
+        cli.setTime(1000);
+        cli.process();
+
+        for (int i = 0; i < 5; ++i) {
+            embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "msg %d", i);
+        }
+        cli.setTime(1001);
+        embeddedCliLog(cli.raw(), CLI_LOG_INFO, 0, "msg %d", 5);
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 5);
+        REQUIRE(displayed.lines[1] == "I: msg 1");
+        REQUIRE(displayed.lines[2] == "W: 3 messages dropped");
+        REQUIRE(displayed.lines[3] == "I: msg 5");
+    }
+}
+
+TEST_CASE("CLI. Log level command", "[cli]") {
+    CliWrapper cli = CliBuilder().logSourceCount(2).build();
+    embeddedCliSetLogSourceName(cli.raw(), 0, "uart");
+    REQUIRE(embeddedCliAddLogLevelBinding(cli.raw()));
+
+    SECTION("Levels are printed without arguments") {
+        cli.sendLine("log-level");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 5);
+        REQUIRE(displayed.lines[1] == " * uart: info");
+        REQUIRE(displayed.lines[2] == " * 1: info");
+        REQUIRE(displayed.lines[3] == " * default: info");
+    }
+
+    SECTION("Level is changed for all sources") {
+        cli.sendLine("log-level error");
+        cli.process();
+
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_WARNING, 0));
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_WARNING, 1));
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_WARNING, 10));
+        REQUIRE(embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_ERROR, 10));
+    }
+
+    SECTION("Level is changed for single source by name or index") {
+        cli.sendLine("log-level uart debug");
+        cli.sendLine("log-level 1 none");
+        cli.process();
+
+        REQUIRE(embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_DEBUG, 0));
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_ERROR, 1));
+        REQUIRE(!embeddedCliIsLogEnabled(cli.raw(), CLI_LOG_DEBUG, 10));
+    }
+
+    SECTION("Unknown source and level are reported") {
+        cli.sendLine("log-level spi debug");
+        cli.sendLine("log-level verbose");
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines[1] == "Unknown log source: \"spi\"");
+        REQUIRE(displayed.lines[3] == "Unknown log level: \"verbose\"");
+    }
+}
@@ -0,0 +1,282 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("CLI. Output", "[cli]") {
+    SECTION("Output is written with writeChars when tx buffer is disabled") {
+        CliWrapper cli = CliBuilder().build();
+        cli.enableWriteChars();
+
+        cli.process();
+        REQUIRE(cli.getWriteCallCount() == 1);
+
+        cli.print("test print");
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "test print");
+        REQUIRE(display.lines[1] == ">");
+    }
+
+    SECTION("Can't create with tx buffer of single char") {
+        EmbeddedCliConfig config = *embeddedCliDefaultConfig();
+        config.txBufferSize = 1;
+
+        REQUIRE(embeddedCliNew(&config) == nullptr);
+    }
+
+    SECTION("Whole processing is written with single call when tx buffer is enabled") {
+        CliWrapper cli = CliBuilder().txBufferSize(128).build();
+        cli.enableWriteChars();
+        cli.addBinding("get");
+
+        cli.sendLine("get led");
+        cli.process();
+        REQUIRE(cli.getWriteCallCount() == 1);
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "> get led");
+        REQUIRE(display.lines[1] == ">");
+    }
+
+    SECTION("Nested output transactions are written when outermost is ended") {
+        CliWrapper cli = CliBuilder().txBufferSize(128).build();
+        cli.enableWriteChars();
+        cli.process();
+        size_t initialCalls = cli.getWriteCallCount();
+
+        embeddedCliBeginOutput(cli.raw());
+        cli.print("first");
+        cli.print("second");
+        REQUIRE(cli.getWriteCallCount() == initialCalls);
+        embeddedCliEndOutput(cli.raw());
+        REQUIRE(cli.getWriteCallCount() == initialCalls + 1);
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 3);
+        REQUIRE(display.lines[0] == "first");
+        REQUIRE(display.lines[1] == "second");
+        REQUIRE(display.lines[2] == ">");
+    }
+
+    SECTION("Output is flushed when tx buffer is full") {
+        CliWrapper cli = CliBuilder().txBufferSize(8).build();
+        cli.enableWriteChars();
+        cli.process();
+
+        cli.print("some long string that doesn't fit");
+
+        REQUIRE(cli.getWriteCallCount() > 1);
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "some long string that doesn't fit");
+        REQUIRE(display.lines[1] == ">");
+    }
+
+    SECTION("writeChar is used when writeChars is not set") {
+        CliWrapper cli = CliBuilder().txBufferSize(128).build();
+
+        cli.process();
+
+        REQUIRE(cli.getWriteCallCount() == 2);
+        REQUIRE(cli.getDisplay().lines[0] == ">");
+    }
+}
+
+TEST_CASE("CLI. Output drained by application", "[cli]") {
+    SECTION("Output is kept in tx buffer until drained") {
+        CliWrapper cli = CliBuilder().autocomplete(false).txBufferSize(64).build();
+        cli.disableWrite();
+
+        cli.send("get");
+        cli.process();
+        REQUIRE(cli.getRawOutput().empty());
+
+        const char *data;
+        uint16_t len;
+        REQUIRE(embeddedCliTxPeek(cli.raw(), &data, &len));
+        REQUIRE(len == 5);
+        REQUIRE(std::string(data, len) == "> get");
+
+        REQUIRE(cli.drainTx() == 5);
+        REQUIRE(!embeddedCliTxPeek(cli.raw(), &data, &len));
+        REQUIRE(cli.getDisplay().lines[0] == "> get");
+    }
+
+    SECTION("Wrapped output is peeked in contiguous parts") {
+        CliWrapper cli = CliBuilder().autocomplete(false).txBufferSize(8).build();
+        cli.disableWrite();
+
+        cli.send("abcde");
+        cli.process();
+        REQUIRE(cli.drainTx() == 7);
+
+        cli.send("fgh");
+        cli.process();
+
+        const char *data;
+        uint16_t len;
+        REQUIRE(embeddedCliTxPeek(cli.raw(), &data, &len));
+        REQUIRE(len == 1);
+        REQUIRE(cli.drainTx() == 3);
+        REQUIRE(cli.getDisplay().lines[0] == "> abcdefgh");
+    }
+
+    SECTION("Drop policy discards chunks that don't fit") {
+        CliWrapper cli = CliBuilder().txBufferSize(8).txPolicy(CLI_TX_POLICY_DROP).build();
+        cli.disableWrite();
+        cli.process();
+
+        embeddedCliBeginOutput(cli.raw());
+        cli.print("long text");
+        REQUIRE(!embeddedCliEndOutput(cli.raw()));
+
+        cli.drainTx();
+        auto output = cli.getRawOutput();
+        REQUIRE(output.find("> ") == 0);
+        REQUIRE(output.find('l') == std::string::npos);
+    }
+
+    SECTION("Report policy discards whole chunk") {
+        CliWrapper cli = CliBuilder().txBufferSize(16).txPolicy(CLI_TX_POLICY_REPORT).build();
+        cli.disableWrite();
+        cli.process();
+        cli.drainTx();
+
+        embeddedCliBeginOutput(cli.raw());
+        cli.print("some long text");
+        REQUIRE(!embeddedCliEndOutput(cli.raw()));
+
+        cli.drainTx();
+        REQUIRE(cli.getRawOutput().find("long") == std::string::npos);
+
+        embeddedCliBeginOutput(cli.raw());
+        cli.print("a");
+        REQUIRE(embeddedCliEndOutput(cli.raw()));
+    }
+
+    SECTION("Block policy waits until output is consumed") {
+        CliWrapper cli = CliBuilder().txBufferSize(8).txPolicy(CLI_TX_POLICY_BLOCK).build();
+        cli.disableWrite();
+        cli.setTime(0);
+        // transfer is "started" and finished immediately
+        cli.raw()->onTxAvailable = [](EmbeddedCli *embeddedCli) {
+            auto *wrapper = (CliWrapper *) embeddedCli->appContext;
+            wrapper->drainTx();
+        };
+        cli.process();
+
+        cli.print("some long string that doesn't fit");
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "some long string that doesn't fit");
+        REQUIRE(display.lines[1] == ">");
+    }
+
+    SECTION("Block policy discards rest of transaction when output is not consumed") {
+        CliWrapper cli = CliBuilder().txBufferSize(16).txPolicy(CLI_TX_POLICY_BLOCK).build();
+        cli.disableWrite();
+        // clock runs while cli waits
+        cli.raw()->getTimeMs = [](EmbeddedCli *embeddedCli) {
+            (void) embeddedCli;
+            static uint32_t now = 0;
+            return now += 10;
+        };
+        cli.process();
+        cli.drainTx();
+        size_t outputSize = cli.getOutputSize();
+
+        embeddedCliBeginOutput(cli.raw());
+        embeddedCliPrint(cli.raw(), "first");
+        embeddedCliPrint(cli.raw(), "second");
+        embeddedCliPrint(cli.raw(), "third");
+        REQUIRE_FALSE(embeddedCliEndOutput(cli.raw()));
+
+        cli.drainTx();
+        std::string output = cli.getRawOutput().substr(outputSize);
+        REQUIRE(output.find("first") != std::string::npos);
+        REQUIRE(output.find("sec") == std::string::npos);
+        REQUIRE(output.find("third") == std::string::npos);
+    }
+
+    SECTION("Block policy doesn't wait without clock") {
+        CliWrapper cli = CliBuilder().txBufferSize(8).txPolicy(CLI_TX_POLICY_BLOCK).build();
+        cli.disableWrite();
+        cli.process();
+        cli.drainTx();
+
+        embeddedCliBeginOutput(cli.raw());
+        embeddedCliPrint(cli.raw(), "some long string that doesn't fit");
+        REQUIRE_FALSE(embeddedCliEndOutput(cli.raw()));
+    }
+}
+
+TEST_CASE("CLI. Capture", "[cli]") {
+    CliWrapper cli = CliBuilder().capture(32).build();
+    embeddedCliAddBinding(cli.raw(), {
+            .name = "status",
+            .help = nullptr,
+            .tokenizeArgs = true,
+            .context = nullptr,
+            .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                (void) context;
+                embeddedCliPrintf(embeddedCli, "led: %s", embeddedCliGetToken(args, 1));
+                embeddedCliPrint(embeddedCli, "fan: off");
+            }
+    });
+    cli.send("abc");
+    cli.process();
+    size_t outputSize = cli.getOutputSize();
+
+    char buf[128];
+    uint16_t len;
+
+    SECTION("Output of command is collected into buffer") {
+        REQUIRE(embeddedCliCapture(cli.raw(), "status on", buf, sizeof(buf), &len));
+
+        REQUIRE(std::string(buf, len) == "led: on\r\nfan: off\r\n");
+        REQUIRE(cli.getOutputSize() == outputSize);
+    }
+
+    SECTION("Output is truncated when buffer is too small") {
+        REQUIRE(!embeddedCliCapture(cli.raw(), "status on", buf, 10, &len));
+
+        REQUIRE(std::string(buf, len) == "led: on\r\nf");
+    }
+
+    SECTION("Output filter is applied to captured output") {
+        REQUIRE(embeddedCliCapture(cli.raw(), "status on | grep fan", buf, sizeof(buf), &len));
+
+        REQUIRE(std::string(buf, len) == "fan: off\r\n");
+    }
+
+    SECTION("Unknown command is reported in captured output") {
+        cli.raw()->onCommand = nullptr;
+        REQUIRE(embeddedCliCapture(cli.raw(), "stat", buf, sizeof(buf), &len));
+
+        REQUIRE(std::string(buf, len).find("Unknown command") == 0);
+    }
+
+    SECTION("Too long command is not executed") {
+        REQUIRE(!embeddedCliCapture(cli.raw(), "status with very long arguments", buf, sizeof(buf), &len));
+        REQUIRE(len == 0);
+    }
+
+    SECTION("Input line and history are not changed") {
+        embeddedCliCapture(cli.raw(), "status on", buf, sizeof(buf), &len);
+        cli.send("d");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 1);
+        REQUIRE(lines[0] == "> abcd");
+
+        cli.send("\x1B[A");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines[0] == "> abcd");
+    }
+}
@@ -0,0 +1,166 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("CLI. Print queue", "[cli]") {
+    SECTION("Posted messages are printed during processing") {
+        CliWrapper cli = CliBuilder().printQueue(4, 16).build();
+        cli.send("cmd");
+        cli.process();
+        size_t echoSize = cli.getRawOutput().size();
+
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "first"));
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "second"));
+        REQUIRE(cli.getDisplay().lines.size() == 1);
+
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "first");
+        REQUIRE(displayed.lines[1] == "second");
+        REQUIRE(displayed.lines[2] == "> cmd");
+        REQUIRE(displayed.cursorColumn == 5);
+        INFO("Command is printed back only once");
+        std::string redraw = cli.getRawOutput().substr(echoSize);
+        REQUIRE(redraw.find("cmd") == redraw.rfind("cmd"));
+    }
+
+    SECTION("Long messages are truncated") {
+        CliWrapper cli = CliBuilder().printQueue(4, 8).build();
+
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "some long message"));
+        cli.process();
+
+        REQUIRE(cli.getDisplay().lines[0] == "some lo");
+    }
+
+    SECTION("Post fails when queue is full") {
+        // size is rounded down to 2
+        CliWrapper cli = CliBuilder().printQueue(3, 8).build();
+
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "1"));
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "2"));
+        REQUIRE(!embeddedCliPostPrint(cli.raw(), "3"));
+
+        cli.process();
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "4"));
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 4);
+        REQUIRE(displayed.lines[0] == "1");
+        REQUIRE(displayed.lines[1] == "2");
+        REQUIRE(displayed.lines[2] == "4");
+    }
+
+    SECTION("Queue of single message is extended to 2") {
+        CliWrapper cli = CliBuilder().printQueue(1, 8).build();
+
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "1"));
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "2"));
+        REQUIRE(!embeddedCliPostPrint(cli.raw(), "3"));
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "1");
+        REQUIRE(displayed.lines[1] == "2");
+    }
+
+    SECTION("Posted messages are reported to application") {
+        CliWrapper cli = CliBuilder().printQueue(4, 8).build();
+        static int postedCount;
+        postedCount = 0;
+        cli.raw()->onPrintPosted = [](EmbeddedCli *embeddedCli) {
+            (void) embeddedCli;
+            ++postedCount;
+        };
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+
+        REQUIRE(embeddedCliPostPrint(cli.raw(), "1"));
+        REQUIRE(postedCount == 1);
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+        REQUIRE(cli.getDisplay().lines[0] == "1");
+
+        // message posted by command is left for next call
+        embeddedCliAddBinding(cli.raw(), {
+                .name = "post",
+                .help = nullptr,
+                .tokenizeArgs = false,
+                .context = nullptr,
+                .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                    (void) args;
+                    (void) context;
+                    embeddedCliPostPrint(embeddedCli, "2");
+                }
+        });
+        cli.sendLine("post");
+        REQUIRE((embeddedCliProcess(cli.raw()) & CLI_STATUS_PRINT_PENDING) != 0);
+        REQUIRE(postedCount == 2);
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+        REQUIRE(cli.getDisplay().lines[2] == "2");
+    }
+
+    SECTION("Post fails when queue is disabled") {
+        CliWrapper cli = CliBuilder().build();
+
+        REQUIRE(!embeddedCliPostPrint(cli.raw(), "1"));
+    }
+
+    SECTION("Messages from concurrent producers are printed exactly once") {
+        const int producerCount = 8;
+        const int messageCount = 500;
+
+        CliWrapper cli = CliBuilder().printQueue(16, 16).txBufferSize(64).build();
+        cli.enableWriteChars();
+        cli.process();
+
+        std::atomic<int> finishedCount{0};
+        std::vector<std::thread> producers;
+        for (int p = 0; p < producerCount; ++p) {
+            producers.emplace_back([&cli, &finishedCount, p]() {
+                for (int i = 0; i < messageCount; ++i) {
+                    std::string message = std::to_string(p) + ":" + std::to_string(i);
+                    while (!embeddedCliPostPrint(cli.raw(), message.c_str())) {
+                        std::this_thread::yield();
+                    }
+                }
+                ++finishedCount;
+            });
+        }
+
+        while (finishedCount < producerCount) {
+            cli.process();
+        }
+        for (auto &producer: producers) {
+            producer.join();
+        }
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == producerCount * messageCount + 1);
+        std::vector<int> nextMessage(producerCount, 0);
+        for (size_t i = 0; i + 1 < displayed.lines.size(); ++i) {
+            const auto &line = displayed.lines[i];
+            auto separator = line.find(':');
+            REQUIRE(separator != std::string::npos);
+            int p = std::stoi(line.substr(0, separator));
+            int message = std::stoi(line.substr(separator + 1));
+            INFO("Messages of each producer are printed in order");
+            REQUIRE(message == nextMessage[p]);
+            ++nextMessage[p];
+        }
+    }
+}
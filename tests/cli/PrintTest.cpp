@@ -77,3 +77,303 @@ TEST_CASE("CLI. Printing", "[cli]") {
         REQUIRE(displayed.cursorColumn == 3);
     }
 }
+
+TEST_CASE("CLI. Formatted printing", "[cli]") {
+    CliWrapper cli = CliBuilder().build();
+    cli.process();
+
+    SECTION("Print integers") {
+        embeddedCliPrintf(cli.raw(), "%d %i %u %d", 42, -17, 65535u, 0);
+        embeddedCliPrintf(cli.raw(), "%ld %lu %zu", -2147483647L - 1, 4294967295UL, (size_t) 100);
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "42 -17 65535 0");
+        REQUIRE(displayed.lines[1] == "-2147483648 4294967295 100");
+    }
+
+    SECTION("Print short integers") {
+        embeddedCliPrintf(cli.raw(), "%hd %hu %hhd %hhx", 70000, 70000u, 255, 0x1ffu);
+
+        REQUIRE(cli.getDisplay().lines[0] == "4464 4464 -1 ff");
+    }
+
+    SECTION("Long long is printed as is and its argument is skipped") {
+        embeddedCliPrintf(cli.raw(), "%lld %s %llx", 5LL, "name", 6ULL);
+
+        REQUIRE(cli.getDisplay().lines[0] == "%lld name %llx");
+    }
+
+    SECTION("Floating point value is printed as is and its argument is skipped") {
+        embeddedCliPrintf(cli.raw(), "%.2f %s %e %d", 1.5, "name", 2.5, 7);
+
+        REQUIRE(cli.getDisplay().lines[0] == "%.2f name %e 7");
+    }
+
+    SECTION("Print pointer with all digits") {
+        uintptr_t address = sizeof(uintptr_t) > 4 ? (uintptr_t) 0x12345678 << 16 : 0x12345678;
+        embeddedCliPrintf(cli.raw(), "%p", (void *) address);
+
+        std::string expected = sizeof(uintptr_t) > 4 ? "0x123456780000" : "0x12345678";
+        REQUIRE(cli.getDisplay().lines[0] == expected);
+    }
+
+    SECTION("Print hex values") {
+        embeddedCliPrintf(cli.raw(), "%x %X 0x%04x %lX", 255u, 0xabcu, 0x1fu, 0xDEADBEEFUL);
+
+        REQUIRE(cli.getDisplay().lines[0] == "ff ABC 0x001f DEADBEEF");
+    }
+
+    SECTION("Print with width and alignment") {
+        embeddedCliPrintf(cli.raw(), "[%5d][%-5d][%05d][%*u][%3d]", 12, 12, -12, 4, 7u, 12345);
+
+        REQUIRE(cli.getDisplay().lines[0] == "[   12][12   ][-0012][   7][12345]");
+    }
+
+    SECTION("Print strings and chars") {
+        embeddedCliPrintf(cli.raw(), "%s|%-6s|%6s|%.2s|%.*s|%c%c|100%%", "abc", "ab", "ab", "abc", 1, "xyz", 'o', 'k');
+
+        REQUIRE(cli.getDisplay().lines[0] == "abc|ab    |    ab|ab|x|ok|100%");
+    }
+
+    SECTION("Print with long padding") {
+        embeddedCliPrintf(cli.raw(), "%20s|%-20d|", "a", 1);
+
+        REQUIRE(cli.getDisplay().lines[0] == "                   a|1                   |");
+    }
+
+    SECTION("Formatted print keeps current command") {
+        cli.send("test");
+        cli.send("\x1B[D\x1B[D");
+        cli.process();
+        embeddedCliPrintf(cli.raw(), "value: %d", 5);
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 2);
+        REQUIRE(displayed.lines[0] == "value: 5");
+        REQUIRE(displayed.lines[1] == "> test");
+        REQUIRE(displayed.cursorColumn == 4);
+    }
+}
+
+TEST_CASE("CLI. Table printing", "[cli]") {
+    CliWrapper cli = CliBuilder().build();
+    cli.process();
+
+    EmbeddedCliTableColumn columns[] = {
+            {"name", 6, CLI_ALIGN_LEFT},
+            {"count", 6, CLI_ALIGN_RIGHT},
+            {"reg", 8, CLI_ALIGN_LEFT},
+    };
+    EmbeddedCliTable table = {columns, 3};
+
+    SECTION("Rows are padded to fixed column widths") {
+        embeddedCliTableHeader(cli.raw(), &table);
+        embeddedCliTableRow(cli.raw(), &table, "%s%u%08x", "idle", 42u, 0x1fu);
+        embeddedCliTableRow(cli.raw(), &table, "%s%d%x", "main", -7, 0xabcu);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 5);
+        REQUIRE(lines[0] == "name     count  reg");
+        REQUIRE(lines[1] == "------  ------  --------");
+        REQUIRE(lines[2] == "idle        42  0000001f");
+        REQUIRE(lines[3] == "main        -7  abc");
+        REQUIRE(lines[4] == ">");
+    }
+
+    SECTION("Column widths are calculated from all rows") {
+        struct Task {
+            const char *name;
+            unsigned int count;
+        };
+        static const Task tasks[] = {{"idle", 5}, {"network", 123456}};
+
+        embeddedCliPrintTable(cli.raw(), &table, [](EmbeddedCli *embeddedCli, EmbeddedCliTable *t,
+                                                    uint16_t row, void *context) {
+            (void) context;
+            if (row >= 2)
+                return false;
+            embeddedCliTableRow(embeddedCli, t, "%s%u%c", tasks[row].name, tasks[row].count, 'r');
+            return true;
+        }, nullptr);
+
+        REQUIRE(columns[0].width == 7);
+        REQUIRE(columns[1].width == 6);
+        REQUIRE(columns[2].width == 3);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 5);
+        REQUIRE(lines[0] == "name      count  reg");
+        REQUIRE(lines[1] == "-------  ------  ---");
+        REQUIRE(lines[2] == "idle          5  r");
+        REQUIRE(lines[3] == "network  123456  r");
+        REQUIRE(lines[4] == ">");
+    }
+}
+
+TEST_CASE("CLI. Scrollback", "[cli]") {
+    SECTION("Printed output is replayed") {
+        CliWrapper cli = CliBuilder().scrollback(128).build();
+        cli.addBinding("get");
+        cli.process();
+
+        cli.sendLine("get led");
+        cli.process();
+        cli.print("led: on");
+        embeddedCliReplayScrollback(cli.raw(), 0);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 5);
+        REQUIRE(lines[0] == "> get led");
+        REQUIRE(lines[1] == "led: on");
+        REQUIRE(lines[2] == "> get led");
+        REQUIRE(lines[3] == "led: on");
+        REQUIRE(lines[4] == ">");
+
+        // replayed output is not recorded again
+        embeddedCliReplayScrollback(cli.raw(), 0);
+        REQUIRE(cli.getDisplay().lines.size() == 7);
+    }
+
+    SECTION("Oldest output is overwritten") {
+        CliWrapper cli = CliBuilder().scrollback(16).build();
+        cli.process();
+
+        for (int i = 0; i < 5; ++i) {
+            embeddedCliPrintf(cli.raw(), "line-%d", i);
+        }
+        size_t printed = cli.getDisplay().lines.size();
+        embeddedCliReplayScrollback(cli.raw(), 0);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == printed + 2);
+        REQUIRE(lines[printed - 1] == "line-3");
+        REQUIRE(lines[printed] == "line-4");
+    }
+
+    SECTION("Partially overwritten line is not replayed") {
+        // size is not multiple of line length, so oldest line is cut
+        CliWrapper cli = CliBuilder().scrollback(20).build();
+        cli.process();
+
+        for (int i = 0; i < 5; ++i) {
+            embeddedCliPrintf(cli.raw(), "line-%d", i);
+        }
+        size_t printed = cli.getDisplay().lines.size();
+        embeddedCliReplayScrollback(cli.raw(), 0);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == printed + 2);
+        REQUIRE(lines[printed - 1] == "line-3");
+        REQUIRE(lines[printed] == "line-4");
+    }
+
+    SECTION("Only whole lines are replayed") {
+        CliWrapper cli = CliBuilder().scrollback(64).build();
+        cli.process();
+
+        cli.print("first");
+        cli.print("second");
+        embeddedCliReplayScrollback(cli.raw(), 10);
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[2] == "second");
+        REQUIRE(lines[3] == ">");
+    }
+}
+
+TEST_CASE("CLI. Coalesced printing", "[cli]") {
+    SECTION("Command is printed back once at the end of batch") {
+        CliWrapper cli = CliBuilder().build();
+        cli.send("cmd");
+        cli.process();
+        size_t echoSize = cli.getRawOutput().size();
+
+        embeddedCliBeginPrintBatch(cli.raw());
+        cli.print("first");
+        cli.print("second");
+        INFO("Command is not printed back yet");
+        REQUIRE(cli.getDisplay().lines.size() == 3);
+        REQUIRE(cli.getDisplay().lines.back().empty());
+        embeddedCliEndPrintBatch(cli.raw());
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "first");
+        REQUIRE(displayed.lines[1] == "second");
+        REQUIRE(displayed.lines[2] == "> cmd");
+        REQUIRE(displayed.cursorColumn == 5);
+        std::string redraw = cli.getRawOutput().substr(echoSize);
+        REQUIRE(redraw.find("cmd") == redraw.rfind("cmd"));
+    }
+
+    SECTION("Batch produces less output than separate prints") {
+        CliWrapper separate = CliBuilder().build();
+        CliWrapper batched = CliBuilder().build();
+        separate.send("some command");
+        separate.process();
+        batched.send("some command");
+        batched.process();
+
+        embeddedCliBeginPrintBatch(batched.raw());
+        for (int i = 0; i < 10; ++i) {
+            separate.print("log line");
+            batched.print("log line");
+        }
+        embeddedCliEndPrintBatch(batched.raw());
+
+        REQUIRE(batched.getDisplay().lines == separate.getDisplay().lines);
+        REQUIRE(batched.getOutputSize() < separate.getOutputSize());
+    }
+
+    SECTION("Command is printed back before input is processed inside batch") {
+        CliWrapper cli = CliBuilder().build();
+        cli.send("cmd");
+        cli.process();
+
+        embeddedCliBeginPrintBatch(cli.raw());
+        cli.print("first");
+        cli.send("s");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines.back() == "> cmds");
+
+        cli.print("second");
+        embeddedCliEndPrintBatch(cli.raw());
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[0] == "first");
+        REQUIRE(displayed.lines[1] == "second");
+        REQUIRE(displayed.lines[2] == "> cmds");
+    }
+
+    SECTION("Command is printed back when coalesce window is elapsed") {
+        CliWrapper cli = CliBuilder().printCoalesceMs(100).build();
+        cli.setTime(1000);
+        cli.send("cmd");
+        cli.process();
+
+        cli.print("first");
+        cli.setTime(1050);
+        cli.print("second");
+        cli.setTime(1100);
+        cli.process();
+        INFO("Command is not printed back yet");
+        REQUIRE(cli.getDisplay().lines.size() == 3);
+        REQUIRE(cli.getDisplay().lines.back().empty());
+
+        cli.setTime(1150);
+        cli.process();
+
+        auto displayed = cli.getDisplay();
+
+        REQUIRE(displayed.lines.size() == 3);
+        REQUIRE(displayed.lines[2] == "> cmd");
+        REQUIRE(displayed.cursorColumn == 5);
+    }
+}
@@ -0,0 +1,428 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ReceivedCommands {
+    std::atomic<int> count{0};
+    std::vector<std::string> args;
+};
+
+static void addSetBinding(CliWrapper &cli, ReceivedCommands &received) {
+    embeddedCliAddBinding(cli.raw(), {
+            .name = "set",
+            .help = nullptr,
+            .tokenizeArgs = false,
+            .context = &received,
+            .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                (void) embeddedCli;
+                auto *commands = (ReceivedCommands *) context;
+                commands->args.emplace_back(args != nullptr ? args : "");
+                commands->count.fetch_add(1, std::memory_order_release);
+            }
+    });
+}
+
+static void receiveFromOtherThread(uint16_t rxBufferSize) {
+    const int commandCount = 5000;
+    // commands are sent only when there is enough space for them in rx
+    // buffer, so none of them is dropped
+    const int maxPending = 4;
+
+    CliWrapper cli = CliBuilder().rxBufferSize(rxBufferSize).build();
+    ReceivedCommands received;
+    addSetBinding(cli, received);
+
+    // assertions are not thread safe, so result of producer is checked later
+    bool allAccepted = true;
+    std::thread producer([&cli, &received, &allAccepted]() {
+        for (int i = 0; i < commandCount; ++i) {
+            while (i - received.count.load(std::memory_order_acquire) >= maxPending) {
+                std::this_thread::yield();
+            }
+            std::string command = "set " + std::to_string(i) + "\r";
+            // both receive functions are used by producer
+            if (i % 2 == 0) {
+                if (embeddedCliReceiveBuffer(cli.raw(), command.c_str(), (uint16_t) command.size()) != command.size())
+                    allAccepted = false;
+            } else {
+                for (char c: command) {
+                    embeddedCliReceiveChar(cli.raw(), c);
+                }
+            }
+        }
+    });
+
+    while (received.count.load(std::memory_order_acquire) < commandCount) {
+        cli.process();
+    }
+    producer.join();
+
+    REQUIRE(allAccepted);
+    REQUIRE(received.args.size() == commandCount);
+    for (int i = 0; i < commandCount; ++i) {
+        REQUIRE(received.args[i] == std::to_string(i));
+    }
+}
+
+TEST_CASE("CLI. Receiving from other thread", "[cli]") {
+    SECTION("Buffer size is a power of two") {
+        receiveFromOtherThread(64);
+    }
+
+    SECTION("Buffer size is not a power of two") {
+        receiveFromOtherThread(50);
+    }
+}
+
+TEST_CASE("CLI. Receive throughput", "[.][benchmark]") {
+    std::string chunk;
+    while (chunk.size() < 4096) {
+        chunk += "set led 1 " + std::to_string(chunk.size()) + "\r\n";
+    }
+
+    for (uint16_t rxBufferSize: {1024, 1000}) {
+        CliWrapper cli = CliBuilder().rxBufferSize(rxBufferSize).build();
+        // output is discarded, so only input processing is measured
+        cli.raw()->writeChar = [](EmbeddedCli *embeddedCli, char c) {
+            (void) embeddedCli;
+            (void) c;
+        };
+        cli.raw()->writeChars = nullptr;
+        ReceivedCommands received;
+        addSetBinding(cli, received);
+
+        BENCHMARK("Receive by chars, rx buffer " + std::to_string(rxBufferSize)) {
+            for (size_t i = 0; i < chunk.size(); i += 512) {
+                for (size_t j = i; j < i + 512 && j < chunk.size(); ++j) {
+                    embeddedCliReceiveChar(cli.raw(), chunk[j]);
+                }
+                cli.process();
+            }
+            received.args.clear();
+            return received.count.load();
+        };
+
+        BENCHMARK("Receive by buffer, rx buffer " + std::to_string(rxBufferSize)) {
+            for (size_t i = 0; i < chunk.size(); i += 512) {
+                size_t len = std::min<size_t>(512, chunk.size() - i);
+                embeddedCliReceiveBuffer(cli.raw(), &chunk[i], (uint16_t) len);
+                cli.process();
+            }
+            received.args.clear();
+            return received.count.load();
+        };
+    }
+}
+
+TEST_CASE("CLI. Receiving from attached buffer", "[cli]") {
+    CliWrapper cli = CliBuilder().rxBufferSize(0).build();
+    auto &commands = cli.getReceivedCommands();
+
+    char dmaBuffer[16];
+    embeddedCliAttachRxBuffer(cli.raw(), dmaBuffer, sizeof(dmaBuffer));
+    size_t writeIndex = 0;
+    auto receive = [&](const std::string &chars) {
+        for (char c: chars) {
+            dmaBuffer[writeIndex] = c;
+            writeIndex = (writeIndex + 1) % sizeof(dmaBuffer);
+        }
+        embeddedCliSetRxWriteIndex(cli.raw(), (uint16_t) writeIndex);
+    };
+
+    SECTION("Chars are processed up to write index") {
+        receive("set led");
+        cli.process();
+        REQUIRE(cli.getDisplay().lines[0] == "> set led");
+
+        receive(" 1\r\n");
+        cli.process();
+        REQUIRE(commands.size() == 1);
+        REQUIRE(commands.back().args[0] == "led 1");
+    }
+
+    SECTION("Chars are processed when buffer wraps around") {
+        for (int i = 0; i < 10; ++i) {
+            receive("set " + std::to_string(i) + "\r\n");
+            cli.process();
+        }
+
+        REQUIRE(commands.size() == 10);
+        REQUIRE(commands.back().args[0] == "9");
+    }
+
+    SECTION("Rx buffer is not taken from cli buffer") {
+        EmbeddedCliConfig config = *embeddedCliDefaultConfig();
+        uint16_t withRxBuffer = embeddedCliRequiredSize(&config);
+        config.rxBufferSize = 0;
+
+        REQUIRE(embeddedCliRequiredSize(&config) < withRxBuffer);
+    }
+
+    SECTION("Chars are dropped until buffer is attached") {
+        CliWrapper detached = CliBuilder().rxBufferSize(0).build();
+        const char *line = "set led\r\n";
+        REQUIRE(embeddedCliReceiveBuffer(detached.raw(), line, 9) == 0);
+        embeddedCliReceiveChar(detached.raw(), 's');
+        detached.process();
+
+        REQUIRE(detached.getReceivedCommands().empty());
+        REQUIRE(detached.getDisplay().lines[0] == ">");
+    }
+}
+
+static std::vector<bool> rxEvents;
+
+TEST_CASE("CLI. Event driven processing", "[cli]") {
+    rxEvents.clear();
+
+    SECTION("Received chars are reported to application") {
+        CliWrapper cli = CliBuilder().build();
+        cli.raw()->onRxAvailable = [](EmbeddedCli *embeddedCli, bool lineComplete) {
+            (void) embeddedCli;
+            rxEvents.push_back(lineComplete);
+        };
+
+        cli.sendLine("a");
+        REQUIRE(rxEvents == std::vector<bool>{false, true, true});
+
+        embeddedCliReceiveBuffer(cli.raw(), "bc", 2);
+        embeddedCliReceiveBuffer(cli.raw(), "d\r", 2);
+        REQUIRE(rxEvents == std::vector<bool>{false, true, true, false, true});
+    }
+
+    SECTION("Chars written to attached buffer are reported to application") {
+        CliWrapper cli = CliBuilder().rxBufferSize(0).build();
+        cli.raw()->onRxAvailable = [](EmbeddedCli *embeddedCli, bool lineComplete) {
+            (void) embeddedCli;
+            rxEvents.push_back(lineComplete);
+        };
+        char dmaBuffer[8] = "abc\r\ndf";
+        embeddedCliAttachRxBuffer(cli.raw(), dmaBuffer, sizeof(dmaBuffer));
+
+        embeddedCliSetRxWriteIndex(cli.raw(), 3);
+        embeddedCliSetRxWriteIndex(cli.raw(), 3);
+        embeddedCliSetRxWriteIndex(cli.raw(), 6);
+        cli.process();
+        embeddedCliSetRxWriteIndex(cli.raw(), 1);
+        REQUIRE(rxEvents == std::vector<bool>{false, true, false});
+    }
+
+    SECTION("Cli is idle when all input is processed") {
+        CliWrapper cli = CliBuilder().build();
+        cli.sendLine("get led");
+
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+    }
+
+    SECTION("Output that is not drained is reported") {
+        CliWrapper cli = CliBuilder().txBufferSize(64).build();
+        cli.disableWrite();
+        cli.send("get");
+
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_OUTPUT_PENDING);
+        cli.drainTx();
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+    }
+
+    SECTION("Time until hidden command is printed back is reported") {
+        CliWrapper cli = CliBuilder().printCoalesceMs(100).build();
+        cli.setTime(1000);
+        cli.send("cmd");
+        cli.process();
+        uint32_t delayMs;
+        REQUIRE(!embeddedCliGetWakeDelay(cli.raw(), &delayMs));
+
+        cli.print("text");
+        cli.setTime(1030);
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_TIMER_PENDING);
+        REQUIRE(embeddedCliGetWakeDelay(cli.raw(), &delayMs));
+        REQUIRE(delayMs == 70);
+
+        cli.setTime(1100);
+        REQUIRE(embeddedCliProcess(cli.raw()) == CLI_STATUS_IDLE);
+        REQUIRE(cli.getDisplay().lines.back() == "> cmd");
+    }
+}
+
+static std::vector<bool> throttleEvents;
+
+TEST_CASE("CLI. Flow control", "[cli]") {
+    throttleEvents.clear();
+    const char xon = 0x11;
+    const char xoff = 0x13;
+
+    SECTION("XOFF is sent at high watermark and XON when input is processed") {
+        CliWrapper cli = CliBuilder().rxBufferSize(16).txBufferSize(64).xonXoff(8, 2).build();
+        auto &commands = cli.getReceivedCommands();
+        cli.process();
+        size_t outputSize = cli.getOutputSize();
+
+        cli.send("get led");
+        cli.send("\n");
+        cli.send("set");
+        // nothing is written from receiving side
+        REQUIRE(cli.getOutputSize() == outputSize);
+
+        cli.process();
+        auto output = cli.getOutputWithEscSeq();
+        REQUIRE(std::count(output.begin(), output.end(), xoff) == 1);
+        REQUIRE(std::count(output.begin(), output.end(), xon) == 1);
+        REQUIRE(output[outputSize] == xoff);
+        REQUIRE(output.find(xon) > output.find(xoff));
+        REQUIRE(commands.size() == 1);
+    }
+
+    SECTION("Flow control char is peeked before paused output") {
+        CliWrapper cli = CliBuilder().rxBufferSize(16).txBufferSize(64).xonXoff(8, 2).build();
+        cli.disableWrite();
+        cli.process();
+        cli.drainTx();
+
+        cli.send(std::string(1, xoff) + "get");
+        cli.process();
+        cli.send(" led on 1");
+        REQUIRE((embeddedCliProcessBudget(cli.raw(), 1, 0, nullptr)));
+
+        const char *data;
+        uint16_t len;
+        REQUIRE(embeddedCliTxPeek(cli.raw(), &data, &len));
+        REQUIRE(len == 1);
+        REQUIRE(data[0] == xoff);
+        embeddedCliTxConsume(cli.raw(), 1);
+        // the rest of output is paused
+        REQUIRE_FALSE(embeddedCliTxPeek(cli.raw(), &data, &len));
+    }
+
+    SECTION("Input is throttled with callback") {
+        CliWrapper cli = CliBuilder().rxBufferSize(16).build();
+        cli.raw()->onRxThrottle = [](EmbeddedCli *embeddedCli, bool throttle) {
+            (void) embeddedCli;
+            throttleEvents.push_back(throttle);
+        };
+
+        cli.send("get led on");
+        cli.send("1");
+        REQUIRE(throttleEvents.empty());
+        cli.send("2");
+        REQUIRE(throttleEvents == std::vector<bool>{true});
+
+        cli.process();
+        REQUIRE(throttleEvents == std::vector<bool>{true, false});
+        REQUIRE(cli.getOutputWithEscSeq().find(xoff) == std::string::npos);
+    }
+
+    SECTION("Output is kept in tx buffer while it is paused") {
+        CliWrapper cli = CliBuilder().txBufferSize(64).xonXoff(0, 0).build();
+        cli.process();
+        size_t outputSize = cli.getOutputSize();
+
+        cli.send(std::string(1, xoff) + "abc");
+        REQUIRE((embeddedCliProcess(cli.raw()) & CLI_STATUS_OUTPUT_PENDING) != 0);
+        REQUIRE(cli.getOutputSize() == outputSize);
+
+        cli.send(std::string(1, xon));
+        cli.process();
+        auto displayed = cli.getDisplay();
+        REQUIRE(displayed.lines[0] == "> abc");
+        REQUIRE(displayed.cursorColumn == 5);
+    }
+
+    SECTION("Output drained by application is paused") {
+        CliWrapper cli = CliBuilder().txBufferSize(64).xonXoff(0, 0).build();
+        cli.disableWrite();
+        cli.raw()->onTxAvailable = [](EmbeddedCli *embeddedCli) {
+            auto *wrapper = (CliWrapper *) embeddedCli->appContext;
+            wrapper->drainTx();
+        };
+
+        cli.send(std::string(1, xoff) + "abc");
+        cli.process();
+        REQUIRE(cli.getOutputSize() == 0);
+
+        cli.send(std::string(1, xon));
+        REQUIRE(cli.getOutputSize() == 0);
+        REQUIRE((embeddedCliProcess(cli.raw()) & CLI_STATUS_OUTPUT_PENDING) == 0);
+        REQUIRE(cli.getDisplay().lines[0] == "> abc");
+    }
+
+    SECTION("Paused output that doesn't fit into tx buffer is discarded") {
+        CliWrapper cli = CliBuilder().txBufferSize(8).xonXoff(0, 0).build();
+        cli.process();
+        cli.send(std::string(1, xoff));
+        cli.process();
+
+        embeddedCliBeginOutput(cli.raw());
+        embeddedCliPrint(cli.raw(), "some long string that doesn't fit");
+        REQUIRE_FALSE(embeddedCliEndOutput(cli.raw()));
+
+        cli.send(std::string(1, xon));
+        cli.process();
+        REQUIRE(cli.getRawOutput().find("some") == std::string::npos);
+    }
+
+    SECTION("Can't create with XON/XOFF without tx buffer") {
+        EmbeddedCliConfig config = *embeddedCliDefaultConfig();
+        config.xonXoff = true;
+        config.txBufferSize = 0;
+
+        REQUIRE(embeddedCliNew(&config) == nullptr);
+    }
+}
+
+static uint32_t testClockMicros = 0;
+
+TEST_CASE("CLI. Processing with budget", "[cli]") {
+    CliWrapper cli = CliBuilder().build();
+    auto &commands = cli.getReceivedCommands();
+    cli.process();
+
+    SECTION("Processing is stopped when char budget is spent") {
+        cli.sendLine("set led 1");
+
+        REQUIRE(embeddedCliProcessBudget(cli.raw(), 4, 0, nullptr));
+        REQUIRE(cli.getDisplay().lines[0] == "> set");
+
+        REQUIRE(embeddedCliProcessBudget(cli.raw(), 4, 0, nullptr));
+        REQUIRE(commands.empty());
+        REQUIRE(!embeddedCliProcessBudget(cli.raw(), 4, 0, nullptr));
+        REQUIRE(commands.size() == 1);
+        REQUIRE(commands.back().args[0] == "led 1");
+    }
+
+    SECTION("Escape sequence is processed across calls") {
+        cli.send("abc\x1B[Dx");
+
+        while (embeddedCliProcessBudget(cli.raw(), 1, 0, nullptr));
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines[0] == "> abxc");
+        REQUIRE(display.cursorColumn == 5);
+    }
+
+    SECTION("Processing is stopped when time budget is spent") {
+        testClockMicros = 0;
+        // each clock read advances time by 10us
+        auto clock = [](EmbeddedCli *embeddedCli) -> uint32_t {
+            (void) embeddedCli;
+            testClockMicros += 10;
+            return testClockMicros;
+        };
+        cli.send("abcdef");
+        cli.process();
+        cli.send("\b\b\b\b\b");
+
+        REQUIRE(embeddedCliProcessBudget(cli.raw(), 0, 25, clock));
+        REQUIRE(cli.getDisplay().lines[0] == "> abc");
+
+        REQUIRE(!embeddedCliProcessBudget(cli.raw(), 0, 0, clock));
+        REQUIRE(cli.getDisplay().lines[0] == "> a");
+    }
+}
@@ -18,6 +18,13 @@ TEST_CASE("CLI. Static allocation", "[cli]") {
         }
     }
 
+    SECTION("Can't create when required size doesn't fit into 16 bits") {
+        config->printQueueSize = 1024;
+        config->printQueueMessageSize = 64;
+        REQUIRE(embeddedCliRequiredSize(config) == 0);
+        REQUIRE(embeddedCliNew(config) == nullptr);
+    }
+
     SECTION("Successful with minimal size") {
         CliWrapper cli = CliBuilder()
                 .staticAllocation()
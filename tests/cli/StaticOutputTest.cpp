@@ -0,0 +1,82 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+
+
+TEST_CASE("CLI. Static output", "[cli]") {
+    const char xon = 0x11;
+    const char xoff = 0x13;
+
+    SECTION("Output is written without tx buffer") {
+        CliWrapper cli = CliBuilder().build();
+        cli.addBinding("get");
+        cli.process();
+
+        cli.print("test print");
+        cli.sendLine("get led");
+        cli.process();
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 3);
+        REQUIRE(display.lines[0] == "test print");
+        REQUIRE(display.lines[1] == "> get led");
+        REQUIRE(display.lines[2] == ">");
+    }
+
+    SECTION("Whole processing is written with single call when tx buffer is enabled") {
+        CliWrapper cli = CliBuilder().txBufferSize(128).build();
+        cli.addBinding("get");
+        cli.process();
+        size_t initialCalls = cli.getWriteCallCount();
+
+        cli.sendLine("get led");
+        cli.process();
+        REQUIRE(cli.getWriteCallCount() == initialCalls + 1);
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "> get led");
+        REQUIRE(display.lines[1] == ">");
+    }
+
+    SECTION("Flow control chars are written when input is processed") {
+        CliWrapper cli = CliBuilder().rxBufferSize(16).txBufferSize(64).xonXoff(8, 2).build();
+        cli.process();
+        size_t outputSize = cli.getOutputSize();
+
+        cli.send("get led");
+        cli.send("\n");
+        cli.send("set");
+        REQUIRE(cli.getOutputSize() == outputSize);
+
+        cli.process();
+        auto output = cli.getOutputWithEscSeq();
+        REQUIRE(std::count(output.begin(), output.end(), xoff) == 1);
+        REQUIRE(std::count(output.begin(), output.end(), xon) == 1);
+        REQUIRE(output[outputSize] == xoff);
+        REQUIRE(output.find(xon) > output.find(xoff));
+    }
+
+    SECTION("Paused output is written after XON") {
+        CliWrapper cli = CliBuilder().txBufferSize(128).xonXoff(8, 2).build();
+        cli.process();
+
+        cli.send(std::string(1, xoff));
+        cli.process();
+        size_t outputSize = cli.getOutputSize();
+
+        cli.print("paused");
+        REQUIRE(cli.getOutputSize() == outputSize);
+
+        cli.send(std::string(1, xon));
+        cli.process();
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.size() == 2);
+        REQUIRE(display.lines[0] == "paused");
+        REQUIRE(display.lines[1] == ">");
+    }
+}
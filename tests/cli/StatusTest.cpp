@@ -0,0 +1,118 @@
+#include "CliWrapper.h"
+#include "CliBuilder.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+
+TEST_CASE("CLI. Status lines", "[cli]") {
+    CliWrapper cli = CliBuilder().statusLines(2, 16).build();
+    cli.process();
+
+    SECTION("Status lines are drawn when terminal height is known") {
+        REQUIRE(embeddedCliSetStatusLine(cli.raw(), 0, "temp: 21.5 C"));
+        REQUIRE(!embeddedCliSetStatusLine(cli.raw(), 2, "unknown"));
+        REQUIRE(cli.getRawOutput().find("temp") == std::string::npos);
+
+        embeddedCliSetTerminalSize(cli.raw(), 80, 24);
+
+        std::string output = cli.getOutputWithEscSeq();
+        REQUIRE(output.find("\x1B[1;22r") != std::string::npos);
+        REQUIRE(output.find("\x1B[23;1Htemp: 21.5 C\x1B[K") != std::string::npos);
+        REQUIRE(output.find("\x1B[24;1H\x1B[K") != std::string::npos);
+        REQUIRE(cli.getDisplay().lines.back() == ">");
+    }
+
+    SECTION("Content is scrolled only when status area is created") {
+        embeddedCliSetTerminalSize(cli.raw(), 80, 24);
+        size_t outputSize = cli.getOutputSize();
+
+        cli.send("\x1B[24;80R");
+        cli.process();
+
+        std::string output = cli.getOutputWithEscSeq().substr(outputSize);
+        REQUIRE(output.find("\x1B[1;22r") != std::string::npos);
+        REQUIRE(output.find("\x1B[2A") == std::string::npos);
+        REQUIRE(output.find('\n') == std::string::npos);
+        REQUIRE(cli.getDisplay().lines.size() == 3);
+    }
+
+    SECTION("Only changed chars are written") {
+        embeddedCliSetTerminalSize(cli.raw(), 80, 24);
+        embeddedCliSetStatusLine(cli.raw(), 1, "temp: 21.5 C");
+        size_t outputSize = cli.getOutputSize();
+
+        embeddedCliSetStatusLine(cli.raw(), 1, "temp: 21.7 C");
+
+        std::string output = cli.getOutputWithEscSeq().substr(outputSize);
+        REQUIRE(output == "\x1B[s\x1B[24;10H7\x1B[u");
+
+        outputSize = cli.getOutputSize();
+        embeddedCliSetStatusLine(cli.raw(), 1, "temp: 21.7 C");
+        REQUIRE(cli.getOutputSize() == outputSize);
+
+        embeddedCliSetStatusLine(cli.raw(), 1, "temp: 3 C");
+        output = cli.getOutputWithEscSeq().substr(outputSize);
+        REQUIRE(output == "\x1B[s\x1B[24;7H3 C\x1B[K\x1B[u");
+    }
+
+    SECTION("Input line is not affected by status update") {
+        embeddedCliSetTerminalSize(cli.raw(), 80, 24);
+        cli.send("get");
+        cli.process();
+
+        embeddedCliSetStatusLine(cli.raw(), 0, "running");
+
+        auto display = cli.getDisplay();
+        REQUIRE(display.lines.back() == "> get");
+        REQUIRE(display.cursorColumn == 5);
+    }
+
+    SECTION("Status area is not recorded to scrollback") {
+        CliWrapper recorded = CliBuilder().statusLines(2, 16).scrollback(128).build();
+        recorded.process();
+        embeddedCliSetTerminalSize(recorded.raw(), 80, 24);
+        recorded.send("get");
+        recorded.process();
+        size_t outputSize = recorded.getOutputSize();
+
+        embeddedCliReplayScrollback(recorded.raw(), 0);
+        REQUIRE(recorded.getOutputSize() == outputSize);
+    }
+}
+
+TEST_CASE("CLI. Progress", "[cli]") {
+    CliWrapper cli = CliBuilder().build();
+    embeddedCliAddBinding(cli.raw(), {
+            .name = "run",
+            .help = nullptr,
+            .tokenizeArgs = false,
+            .context = nullptr,
+            .binding = [](EmbeddedCli *embeddedCli, char *args, void *context) {
+                (void) args;
+                (void) context;
+                embeddedCliShowProgress(embeddedCli, 0);
+                embeddedCliPrint(embeddedCli, "message");
+                embeddedCliShowProgress(embeddedCli, 40);
+                embeddedCliShowProgress(embeddedCli, 45);
+            }
+    });
+
+    SECTION("Progress is updated in place") {
+        cli.sendLine("run");
+        cli.process();
+
+        auto lines = cli.getDisplay().lines;
+        REQUIRE(lines.size() == 4);
+        REQUIRE(lines[0] == "> run");
+        REQUIRE(lines[1] == "message");
+        REQUIRE(lines[2] == "[#########...........]  45%");
+        REQUIRE(lines[3] == ">");
+    }
+
+    SECTION("Progress can't be shown while input line is displayed") {
+        cli.process();
+
+        REQUIRE(!embeddedCliShowProgress(cli.raw(), 10));
+        REQUIRE(cli.getRawOutput() == "> ");
+    }
+}